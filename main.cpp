@@ -6,18 +6,38 @@
 #include <Pdp8Terminal.h>
 #include <DECWriter.h>
 #include <DK8_EA.h>
+#include <HeadlessRunner.h>
 
 using namespace pdp8;
 
-int main() {
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        try {
+            HeadlessRunner runner{HeadlessRunner::parseArguments(std::span(argv + 1, static_cast<std::size_t>(argc - 1)))};
+            runner.load();
+            auto stopReason = runner.run();
+            runner.report(std::cerr);
+            runner.save();
+            return stopReason == HeadlessRunner::StopReason::Halt ? 0 : 1;
+        } catch (const std::invalid_argument &e) {
+            std::cerr << e.what() << '\n' << HeadlessRunner::Usage;
+            return 2;
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << '\n';
+            return 2;
+        }
+    }
+
     signal(SIGCHLD, SIG_IGN);
 
     PDP8 pdp8{};
+    pdp8.setTimingMode(PDP8::TimingMode::RealTime);
     auto decWriter = std::make_shared<DECWriter>();
-    pdp8.iotDevices[3] = decWriter;
-    pdp8.iotDevices[4] = decWriter;
+    decWriter->setPrintRate(0);     // The console prints as fast as the terminal takes it, see PRINT RATE.
+    pdp8.attachDevice(3, decWriter);
+    pdp8.attachDevice(4, decWriter);
     auto dk8ea = std::make_shared<DK8_EA>();
-    pdp8.iotDevices[013] = dk8ea;
+    pdp8.attachDevice(013, dk8ea);
 
     pdp8.terminalManager.push_back(std::make_shared<Pdp8Terminal>(pdp8));
 
@@ -0,0 +1,84 @@
+/*
+ * pdp8trace.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file pdp8trace.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Disassemble a trace dumped by the PDP8, see TraceBuffer.h, or a trace stream, see TraceStream.h.
+ * @details Usage: pdp8trace trace-file [pal-file]. If the PAL source of the program is given its labels are
+ * shown in place of addresses. A trace stream is disassembled as it is read, so traces larger than memory may
+ * be compared with diff.
+ */
+
+#include <TraceBuffer.h>
+#include <TraceStream.h>
+#include <Snapshot.h>
+#include <assembler/Assembler.h>
+#include <assembler/Disassembler.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace pdp8;
+using namespace pdp8asm;
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: pdp8trace trace-file [pal-file]\n";
+        return 2;
+    }
+
+    try {
+        Disassembler disassembler{};
+        if (argc == 3) {
+            std::ifstream source{argv[2]};
+            if (!source)
+                throw std::runtime_error(fmt::format("Can not open {}", argv[2]));
+            Assembler assembler{};
+            assembler.readProgram(source);
+            if (!assembler.pass1())
+                throw std::runtime_error(fmt::format("Assembly of {} failed", argv[2]));
+            disassembler = Disassembler{assembler.symbolTable};
+        }
+
+        std::ifstream traceFile{argv[1], std::ios::binary};
+        if (!traceFile)
+            throw std::runtime_error(fmt::format("Can not open {}", argv[1]));
+
+        auto print = [&disassembler](const TraceRecord &record) {
+            auto address = static_cast<word_t>(record.location & 07777u);
+            auto label = disassembler.label(address);
+            auto line = fmt::format("{:o}:{:04o} {:<8} {:04o}  {:<20}", record.location >> 12u, address,
+                                    label ? fmt::format("{},", *label) : std::string{}, record.instruction,
+                                    disassembler.disassemble(record.instruction, address));
+            if (record.instruction < 06000u)
+                line += fmt::format(" EA {:o}:{:04o}", record.address >> 12u, record.address & 07777u);
+            else
+                line += fmt::format("{:10}", "");
+            line += fmt::format("  L {:o} AC {:04o} MQ {:04o}\n", (record.arithmetic >> 12u) & 1u,
+                                record.arithmetic & 07777u, record.mulQuotient & 07777u);
+            std::cout << line;
+        };
+
+        std::string magic(TraceDelta::Magic.size(), '\0');
+        traceFile.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+        traceFile.clear();
+        traceFile.seekg(0);
+        if (magic == TraceDelta::Magic) {
+            TraceStreamReader reader{traceFile};
+            for (TraceRecord record{}; reader.next(record);)
+                print(record);
+        } else {
+            for (auto &record: TraceBuffer::read(traceFile))
+                print(record);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
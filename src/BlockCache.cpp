@@ -0,0 +1,193 @@
+/*
+ * BlockCache.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file BlockCache.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "BlockCache.h"
+#include "OprMicrocode.h"
+#include "PDP8.h"
+#include <algorithm>
+
+namespace pdp8 {
+
+    static constexpr small_register_t WordMask = 07777u;
+
+    bool BlockCache::Block::matches(const Memory &memory, std::size_t location) const {
+        for (auto &entry: entries) {
+            if (memory.peek(location) != entry.decoded.word || !memory.initialized(location))
+                return false;
+            ++location;
+        }
+        return true;
+    }
+
+    void BlockCache::executeAnd(PDP8 &pdp8) { pdp8.executeAnd(); }
+    void BlockCache::executeTad(PDP8 &pdp8) { pdp8.executeTad(); }
+    void BlockCache::executeIsz(PDP8 &pdp8) { pdp8.executeIsz(); }
+    void BlockCache::executeDca(PDP8 &pdp8) { pdp8.executeDca(); }
+    void BlockCache::executeJms(PDP8 &pdp8) { pdp8.executeJms(); }
+    void BlockCache::executeJmp(PDP8 &pdp8) { pdp8.executeJmp(); }
+    void BlockCache::executeIot(PDP8 &pdp8) { pdp8.execute_iot(); }
+
+    BlockCache::Handler BlockCache::handlerFor(small_register_t word) {
+        switch (static_cast<OpCode>(word >> 9)) {
+            case OpCode::AND:
+                return &executeAnd;
+            case OpCode::TAD:
+                return &executeTad;
+            case OpCode::ISZ:
+                return &executeIsz;
+            case OpCode::DCA:
+                return &executeDca;
+            case OpCode::JMS:
+                return &executeJms;
+            case OpCode::JMP:
+                return &executeJmp;
+            case OpCode::IOT:
+                return &executeIot;
+            case OpCode::OPR:
+                break;
+        }
+        return OprTable[word & 0777u];
+    }
+
+    bool BlockCache::endsBlock(small_register_t word) {
+        switch (static_cast<OpCode>(word >> 9)) {
+            case OpCode::AND:
+            case OpCode::TAD:
+            case OpCode::DCA:
+                return false;
+            case OpCode::OPR:
+                return (word & 0401u) == 0400u;     // Group 2 skips and HLT
+            default:
+                return true;
+        }
+    }
+
+    std::unique_ptr<BlockCache::Block> BlockCache::translate(Memory &memory, std::size_t location) {
+        if (!memory.initialized(location))
+            return nullptr;
+
+        auto block = std::make_unique<Block>();
+        block->generation = memory.getCodeGeneration();
+        // Blocks stop at the end of the field and before any location that has never been written.
+        auto fieldEnd = (location | WordMask) + 1;
+        for (auto next = location; next < fieldEnd && block->entries.size() < MaxBlockLength; ++next) {
+            if (!memory.initialized(next))
+                break;
+            auto word = memory.peek(next);
+            memory.markTranslated(next);
+            DecodedInstruction decoded{word, static_cast<fast_register_t>(next & WordMask)};
+            block->entries.push_back(Entry{decoded, handlerFor(word),
+                                           decoded.opCode == OpCode::DCA || decoded.mode == AddressMode::AutoIndex});
+            if (endsBlock(word))
+                break;
+        }
+        return block;
+    }
+
+    const BlockCache::Block *BlockCache::lookup(Memory &memory, std::size_t location) {
+        if (blocks.empty())
+            blocks.resize(NumberOfFields * 4096);
+
+        auto &block = blocks[location];
+        if (block && block->generation != memory.getCodeGeneration()) {
+            if (block->matches(memory, location))
+                block->generation = memory.getCodeGeneration();
+            else
+                block.reset();
+        }
+        if (!block)
+            block = translate(memory, location);
+        return block.get();
+    }
+
+    PDP8::RunExit PDP8::runBlocks(unsigned long count, unsigned long maxInstructions) {
+        while (count < maxInstructions) {
+            if (!run_flag)
+                return RunExit::Halt;
+            if (!interruptCheck())
+                return RunExit::IdleWait;
+
+            auto location = (memory.fieldRegister.getInstField() << 12) | memory.programCounter.getProgramCounter();
+            auto block = blockCache.lookup(memory, location);
+            if (block == nullptr) {
+                // Never written, execute it the slow way so the registers show what was fetched.
+                if (breakpointBefore())
+                    return RunExit::Breakpoint;
+                auto &decoded = fetchDecoded();
+                if (decoded.isIndirect())
+                    defer(decoded);
+                execute();
+                retire(decoded.isIndirect());
+                ++count;
+                continue;
+            }
+
+            auto length = std::min<std::size_t>(block->entries.size(), maxInstructions - count);
+            if (lampAccumulator || tracing || memoryChecks ||
+                (breakpointsSet && breakpoints.flags(Breakpoints::Access::Execute, location, location + length))) {
+                // Every instruction must be seen, execute the block one fetch at a time.
+                auto generation = memory.getCodeGeneration();
+                for (std::size_t idx = 0; idx < length; ++idx) {
+                    if (breakpointBefore())
+                        return RunExit::Breakpoint;
+                    auto &decoded = fetchDecoded();
+                    if (decoded.isIndirect())
+                        defer(decoded);
+                    block->entries[idx].handler(*this);
+                    retire(decoded.isIndirect());
+                    ++count;
+                    if (!run_flag)
+                        break;      // A sanitizer trap or watchpoint stopped the CPU.
+                    if (memory.getCodeGeneration() != generation)
+                        break;      // The block may have modified itself.
+                }
+                continue;
+            }
+
+            // Run all but the last instruction from the translation. None of them can transfer control or stop
+            // the CPU, and only AND, TAD and DCA use the memory address.
+            auto generation = memory.getCodeGeneration();
+            auto fieldBase = location & ~static_cast<std::size_t>(WordMask);
+            std::size_t idx = 0;
+            bool modified = false;
+            while (idx + 1 < length) {
+                auto &entry = block->entries[idx++];
+                memory.memoryAddress.value = static_cast<MemoryAddress::base_type>(fieldBase | entry.decoded.address);
+                if (entry.decoded.isIndirect())
+                    defer(entry.decoded);
+                entry.handler(*this);
+                if (entry.writesCore && memory.getCodeGeneration() != generation) {
+                    // The block may have modified itself, leave the registers as if this was fetched last.
+                    instructionReg.value = entry.decoded.word;
+                    fetchLocation = static_cast<fast_register_t>(location + idx - 1);
+                    modified = true;
+                    break;
+                }
+            }
+            instructionCount += idx;
+            count += idx;
+            memory.programCounter.setProgramCounter(
+                    static_cast<ProgramCounter::base_type>((location + idx) & WordMask));
+            if (modified)
+                continue;
+
+            // The last instruction is fetched so the registers match the other engines when the block ends.
+            auto &decoded = fetchDecoded();
+            if (decoded.isIndirect())
+                defer(decoded);
+            block->entries[idx].handler(*this);
+            retire(decoded.isIndirect());
+            ++count;
+        }
+        return run_flag ? RunExit::BudgetExhausted : RunExit::Halt;
+    }
+
+} // pdp8
@@ -0,0 +1,102 @@
+/*
+ * BlockCache.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file BlockCache.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Straight line PDP-8 code translated into cached blocks of predecoded instructions.
+ * @details A block starts at a field and address and runs up to and including the first instruction that may
+ * transfer control: JMP, JMS, ISZ, IOT or a group 2 operate instruction. Each instruction is translated to its
+ * operand address, address mode and the handler that executes it. The ExecutionEngine::Block loop polls devices
+ * and the budget once per block, runs every instruction but the last straight from the translation without
+ * fetching it, and advances the PC and instruction count once. Only the last instruction is fetched, so the
+ * registers are left as the other engines leave them.
+ *
+ * Self modifying code is handled through Memory: every location in a block is marked as translated and a write
+ * to a translated location advances the memory code generation. A block whose generation is stale is checked
+ * against core before it is used again, and the block being executed is abandoned after any instruction which
+ * changes the generation.
+ */
+
+#ifndef PDP8_BLOCKCACHE_H
+#define PDP8_BLOCKCACHE_H
+
+#include <HostInterface.h>
+#include <Instruction.h>
+#include <Memory.h>
+#include <memory>
+#include <vector>
+
+namespace pdp8 {
+
+    class PDP8;
+
+    /**
+     * @class BlockCache
+     * @brief Translated blocks keyed on the 15 bit field and address of their first instruction.
+     */
+    class BlockCache {
+    public:
+        using Handler = void (*)(PDP8 &);
+
+        static constexpr std::size_t MaxBlockLength = 64;
+
+        /**
+         * @brief A translated instruction.
+         */
+        struct Entry {
+            DecodedInstruction decoded{};   ///< The word, with its operand address and address mode resolved.
+            Handler handler{nullptr};
+            bool writesCore{false};         ///< DCA or an auto index defer, which may modify the block.
+        };
+
+        struct Block {
+            unsigned long generation{0};            ///< The memory code generation the block was last checked at.
+            std::vector<Entry> entries{};           ///< One entry per instruction.
+
+            /**
+             * @brief True if core still holds the words the block was translated from.
+             */
+            [[nodiscard]] bool matches(const Memory &memory, std::size_t location) const;
+        };
+
+    protected:
+        std::vector<std::unique_ptr<Block>> blocks{};
+
+        static std::unique_ptr<Block> translate(Memory &memory, std::size_t location);
+
+        static Handler handlerFor(small_register_t word);
+
+        static bool endsBlock(small_register_t word);
+
+        static void executeAnd(PDP8 &pdp8);
+        static void executeTad(PDP8 &pdp8);
+        static void executeIsz(PDP8 &pdp8);
+        static void executeDca(PDP8 &pdp8);
+        static void executeJms(PDP8 &pdp8);
+        static void executeJmp(PDP8 &pdp8);
+        static void executeIot(PDP8 &pdp8);
+
+    public:
+        /**
+         * @brief Find, revalidate or translate the block starting at a location.
+         * @param memory The memory holding the code.
+         * @param location The 15 bit field and address.
+         * @return The block, or nullptr if the location has never been written.
+         */
+        const Block *lookup(Memory &memory, std::size_t location);
+
+        /**
+         * @brief Discard all translated blocks.
+         */
+        void clear() {
+            blocks.clear();
+        }
+    };
+
+} // pdp8
+
+#endif //PDP8_BLOCKCACHE_H
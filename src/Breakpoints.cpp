@@ -0,0 +1,66 @@
+/*
+ * Breakpoints.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Breakpoints.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "Breakpoints.h"
+#include <fmt/format.h>
+
+namespace pdp8 {
+
+    void Breakpoints::set(const Breakpoint &breakpoint) {
+        auto existing = std::find_if(breakpoints.begin(), breakpoints.end(), [&breakpoint](const Breakpoint &b) {
+            return b.access == breakpoint.access && b.location == breakpoint.location;
+        });
+        if (existing != breakpoints.end())
+            *existing = breakpoint;
+        else
+            breakpoints.push_back(breakpoint);
+        flagged[index(breakpoint.access)].set(breakpoint.location);
+    }
+
+    bool Breakpoints::clear(fast_register_t location) {
+        auto removed = std::erase_if(breakpoints, [location](const Breakpoint &b) { return b.location == location; });
+        for (auto &bitmap: flagged)
+            bitmap.reset(location);
+        return removed != 0;
+    }
+
+    void Breakpoints::clear() {
+        breakpoints.clear();
+        for (auto &bitmap: flagged)
+            bitmap.clear();
+    }
+
+    const Breakpoints::Breakpoint *Breakpoints::match(Access access, fast_register_t location,
+                                                      fast_register_t arithmetic) const {
+        if (!flags(access, location))
+            return nullptr;
+        for (auto &breakpoint: breakpoints)
+            if (breakpoint.access == access && breakpoint.location == location
+                && (!breakpoint.arithmetic || breakpoint.arithmetic.value() == (arithmetic & 07777u)))
+                return &breakpoint;
+        return nullptr;
+    }
+
+    std::string Breakpoints::format(const Breakpoint &breakpoint) {
+        static constexpr std::array<std::string_view, 3> Names{"Execute", "Read", "Write"};
+        auto text = fmt::format("{} {:o}:{:04o}", Names[index(breakpoint.access)], breakpoint.location >> 12u,
+                                breakpoint.location & 07777u);
+        if (breakpoint.arithmetic)
+            text += fmt::format(" if AC {:04o}", breakpoint.arithmetic.value());
+        return text;
+    }
+
+    std::string Breakpoints::format(const Hit &hit) {
+        return fmt::format("Breakpoint {} at PC {:o}:{:04o}", format(hit.breakpoint), hit.programCounter >> 12u,
+                           hit.programCounter & 07777u);
+    }
+
+} // pdp8
@@ -0,0 +1,141 @@
+/*
+ * Breakpoints.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Breakpoints.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Execution breakpoints and memory watchpoints.
+ * @details Each kind of access has a CoreBitmap with a bit set at every location that has a breakpoint of that
+ * kind, so the CPU tests one bit before looking further. A breakpoint may also require the AC to hold a value.
+ * An execute breakpoint stops the CPU before the instruction at its location is fetched. A read or write
+ * watchpoint stops it after the instruction that read or wrote its location, which includes indirect address
+ * reads and auto-index writes by a defer cycle. With no breakpoints set the CPU tests a single flag.
+ */
+
+#ifndef PDP8_BREAKPOINTS_H
+#define PDP8_BREAKPOINTS_H
+
+#include <HostInterface.h>
+#include <Memory.h>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pdp8 {
+
+    /**
+     * @class Breakpoints
+     */
+    class Breakpoints {
+    public:
+        enum class Access {
+            Execute,    ///< Stop before the instruction at the location is executed.
+            Read,       ///< Stop after an instruction reads the location.
+            Write,      ///< Stop after an instruction writes the location.
+        };
+
+        /**
+         * @brief A breakpoint. Locations are 15 bit field and address.
+         */
+        struct Breakpoint {
+            Access access{Access::Execute};
+            fast_register_t location{0};
+            std::optional<fast_register_t> arithmetic{};    ///< Only stop when the AC holds this value.
+
+            bool operator==(const Breakpoint &) const = default;
+        };
+
+        /**
+         * @brief The breakpoint that stopped the CPU.
+         */
+        struct Hit {
+            Breakpoint breakpoint;
+            fast_register_t programCounter;         ///< The location of the instruction that made the access.
+        };
+
+    protected:
+        std::vector<Breakpoint> breakpoints{};
+        std::array<CoreBitmap, 3> flagged{};        ///< Indexed by Access.
+        std::optional<Hit> lastHit{};
+
+        static std::size_t index(Access access) {
+            return static_cast<std::size_t>(access);
+        }
+
+    public:
+        /**
+         * @brief Add a breakpoint, replacing any of the same kind at the same location.
+         */
+        void set(const Breakpoint &breakpoint);
+
+        /**
+         * @brief Remove the breakpoints of every kind at a location.
+         * @return True if there were any.
+         */
+        bool clear(fast_register_t location);
+
+        void clear();
+
+        [[nodiscard]] bool empty() const {
+            return breakpoints.empty();
+        }
+
+        /**
+         * @brief True if there are read or write watchpoints.
+         */
+        [[nodiscard]] bool watching() const {
+            return std::any_of(breakpoints.begin(), breakpoints.end(),
+                               [](const Breakpoint &breakpoint) { return breakpoint.access != Access::Execute; });
+        }
+
+        [[nodiscard]] bool flags(Access access, fast_register_t location) const {
+            return flagged[index(access)].test(location);
+        }
+
+        /**
+         * @brief True if any location from first up to, but not including, last has a breakpoint of a kind.
+         */
+        [[nodiscard]] bool flags(Access access, std::size_t first, std::size_t last) const {
+            return flagged[index(access)].any(first, last);
+        }
+
+        /**
+         * @brief Find the breakpoint of a kind at a location whose condition the AC meets.
+         */
+        [[nodiscard]] const Breakpoint *match(Access access, fast_register_t location,
+                                                 fast_register_t arithmetic) const;
+
+        [[nodiscard]] const std::vector<Breakpoint> &getBreakpoints() const {
+            return breakpoints;
+        }
+
+        void record(const Hit &hit) {
+            lastHit = hit;
+        }
+
+        /**
+         * @brief The breakpoint that last stopped the CPU.
+         */
+        [[nodiscard]] const std::optional<Hit> &getHit() const {
+            return lastHit;
+        }
+
+        /**
+         * @brief Describe a breakpoint, for example "Write 0:0300 if AC 0012".
+         */
+        static std::string format(const Breakpoint &breakpoint);
+
+        /**
+         * @brief Describe a hit, for example "Breakpoint Write 0:0300 at PC 0:0202".
+         */
+        static std::string format(const Hit &hit);
+    };
+
+} // pdp8
+
+#endif //PDP8_BREAKPOINTS_H
@@ -0,0 +1,146 @@
+/*
+ * CpuRunner.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file CpuRunner.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "CpuRunner.h"
+
+namespace pdp8 {
+
+    void PanelSnapshot::capture(PDP8 &pdp8) {
+        dataField = pdp8.memory.fieldRegister.getDataField();
+        instField = pdp8.memory.fieldRegister.getInstField();
+        programCounter = pdp8.memory.programCounter.getProgramCounter();
+        memoryAddress = pdp8.memory.memoryAddress.getPageWordAddress();
+        memoryBuffer = pdp8.memory.memoryBuffer.getData();
+        arithmetic = pdp8.accumulator.getArithmetic();
+        stepCounter = pdp8.stepCounter.value;
+        mulQuotient = pdp8.mulQuotient.getWord();
+        opCode = pdp8.instructionReg.getOpCode();
+        cycleState = pdp8.cycle_state;
+        interruptEnable = pdp8.interrupt_enable;
+        runFlag = pdp8.get_run_flag();
+    }
+
+    CpuRunner::CpuRunner(PDP8 &pdp8) : pdp8(pdp8) {
+        publish();
+        thread = std::jthread([this](const std::stop_token &stopToken) {
+            runLoop(stopToken);
+        });
+    }
+
+    CpuRunner::~CpuRunner() {
+        thread.request_stop();
+        commandReady.notify_all();
+        pdp8.idleWakeup->notify();
+    }
+
+    std::future<void> CpuRunner::post(Command command) {
+        std::packaged_task<void(PDP8 &)> task{[this, command = std::move(command)](PDP8 &cpu) {
+            command(cpu);
+            publish();
+        }};
+        auto future = task.get_future();
+        {
+            std::lock_guard guard{commandLock};
+            commands.push_back(std::move(task));
+        }
+        commandReady.notify_one();
+        pdp8.idleWakeup->notify();
+        return future;
+    }
+
+    PanelSnapshot CpuRunner::getSnapshot() const {
+        std::lock_guard guard{snapshotLock};
+        return snapshot;
+    }
+
+    PanelSnapshot CpuRunner::takeFrame() {
+        frameTaken = true;
+        return getSnapshot();
+    }
+
+    std::optional<std::string> CpuRunner::takeFault() {
+        std::lock_guard guard{snapshotLock};
+        return std::exchange(fault, std::nullopt);
+    }
+
+    void CpuRunner::setFault(std::string message) {
+        {
+            std::lock_guard guard{snapshotLock};
+            fault = std::move(message);
+        }
+        pdp8.terminalManager.post();
+    }
+
+    void CpuRunner::publish() {
+        PanelSnapshot next{};
+        next.capture(pdp8);
+        auto harvest = frameTaken.exchange(false);
+        if (harvest)
+            next.hasIntensities = pdp8.harvestLamps(next.intensities);
+        {
+            std::lock_guard guard{snapshotLock};
+            if (!harvest) {
+                next.hasIntensities = snapshot.hasIntensities;
+                next.intensities = snapshot.intensities;
+            }
+            next.sequence = snapshot.sequence + 1;
+            snapshot = next;
+        }
+
+        // Wake the console for the first snapshot after it took a frame, later ones wait for that frame.
+        if (harvest)
+            pdp8.terminalManager.post();
+    }
+
+    void CpuRunner::runLoop(const std::stop_token &stopToken) {
+        while (!stopToken.stop_requested()) {
+            std::deque<std::packaged_task<void(PDP8 &)>> pending{};
+            {
+                std::unique_lock lock{commandLock};
+                if (!pdp8.get_run_flag())
+                    commandReady.wait(lock, stopToken, [this]() { return !commands.empty() || pdp8.get_run_flag(); });
+                pending.swap(commands);
+            }
+
+            for (auto &command: pending)
+                command(pdp8);
+
+            if (!pdp8.get_run_flag())
+                continue;
+
+            try {
+                auto ticket = pdp8.idleWakeup->ticket();
+                auto exit = pdp8.run(BatchSize);
+                if (exit == PDP8::RunExit::IdleWait) {
+                    if (auto wait = pdp8.idleAdvance(); wait > std::chrono::steady_clock::duration::zero())
+                        pdp8.idleWakeup->waitFor(ticket, wait);
+                } else if (auto &hit = pdp8.getBreakpoints().getHit(); exit == PDP8::RunExit::Breakpoint && hit) {
+                    setFault(Breakpoints::format(hit.value()));
+                } else if (auto &access = pdp8.getSanitizer().getLastAccess();
+                        exit == PDP8::RunExit::SanitizerTrap && access) {
+                    setFault(Sanitizer::format(access.value()));
+                }
+            } catch (const std::exception &e) {
+                pdp8.set_run_flag(false);
+                setFault(e.what());
+            }
+
+            publish();
+
+            // In real time, sleep until emulated time catches up unless a command arrives.
+            if (auto due = pdp8.pacingDeadline(); due) {
+                std::unique_lock lock{commandLock};
+                commandReady.wait_until(lock, stopToken, due.value(), [this]() { return !commands.empty(); });
+            }
+        }
+    }
+
+} // pdp8
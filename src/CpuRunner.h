@@ -0,0 +1,145 @@
+/*
+ * CpuRunner.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file CpuRunner.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Run a PDP8 on a dedicated execution thread.
+ * @details The console no longer drives the CPU from the terminal service loop. Commands are posted to the
+ * CpuRunner which applies them on the execution thread between instructions, and the console renders the
+ * front panel from the most recently published PanelSnapshot.
+ */
+
+#ifndef PDP8_CPURUNNER_H
+#define PDP8_CPURUNNER_H
+
+#include <PDP8.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace pdp8 {
+
+    /**
+     * @struct PanelSnapshot
+     * @brief A copy of the CPU state shown on the front panel, taken on the execution thread.
+     */
+    struct PanelSnapshot {
+        fast_register_t dataField{};
+        fast_register_t instField{};
+        fast_register_t programCounter{};
+        fast_register_t memoryAddress{};
+        fast_register_t memoryBuffer{};
+        fast_register_t arithmetic{};
+        fast_register_t stepCounter{};
+        fast_register_t mulQuotient{};
+        fast_register_t opCode{};
+        PDP8::CycleState cycleState{PDP8::CycleState::Interrupt};
+        bool interruptEnable{false};
+        bool runFlag{false};
+        bool hasIntensities{false};         ///< True if intensities holds lamp duty cycles.
+        LampAccumulator::Intensities intensities{};   ///< Lamp duty cycles since the previous frame was taken.
+        unsigned long sequence{0};         ///< Incremented each time a snapshot is published.
+
+        void capture(PDP8 &pdp8);
+    };
+
+    /**
+     * @class CpuRunner
+     * @brief Owns the CPU execution thread.
+     * @details While the PDP8 run flag is set the thread executes batches of instructions with PDP8::run(), checking
+     * the command queue between batches. When the CPU is stopped the thread sleeps until a command is posted, and
+     * while the program idles waiting on a device it sleeps on the PDP8 IdleWakeup until a device, a command or the
+     * next scheduled event wakes it. In PDP8::TimingMode::RealTime the thread sleeps between batches until emulated
+     * time catches up with the host clock.
+     */
+    class CpuRunner {
+    public:
+        using Command = std::function<void(PDP8 &)>;
+
+        static constexpr unsigned long BatchSize = 1024;    ///< Instructions executed between command checks.
+
+
+    protected:
+        PDP8 &pdp8;
+
+        std::mutex commandLock{};
+        std::condition_variable_any commandReady{};
+        std::deque<std::packaged_task<void(PDP8 &)>> commands{};
+
+        mutable std::mutex snapshotLock{};
+        PanelSnapshot snapshot{};
+        std::optional<std::string> fault{};
+        std::atomic_bool frameTaken{true};      ///< Harvest lamp duty cycles at the next publish.
+
+        std::jthread thread;
+
+        void runLoop(const std::stop_token &stopToken);
+
+        void publish();
+
+        /**
+         * @brief Record why the CPU stopped for takeFault() and wake the console.
+         */
+        void setFault(std::string message);
+
+    public:
+        CpuRunner() = delete;
+        CpuRunner(const CpuRunner &) = delete;
+        CpuRunner(CpuRunner &&) = delete;
+        CpuRunner &operator=(const CpuRunner &) = delete;
+        CpuRunner &operator=(CpuRunner &&) = delete;
+
+        explicit CpuRunner(PDP8 &pdp8);
+
+        ~CpuRunner();
+
+        /**
+         * @brief Queue a command to be applied to the PDP8 on the execution thread.
+         * @details A new snapshot is published after the command has been applied.
+         * @param command The command.
+         * @return A future which is ready when the command has been applied.
+         */
+        std::future<void> post(Command command);
+
+        /**
+         * @brief Apply a command to the PDP8 on the execution thread and wait for it to complete.
+         * @param command The command.
+         * @throws Any exception thrown by the command.
+         */
+        void perform(Command command) {
+            post(std::move(command)).get();
+        }
+
+        /**
+         * @brief Get the most recently published panel snapshot.
+         */
+        [[nodiscard]] PanelSnapshot getSnapshot() const;
+
+        /**
+         * @brief Get the most recently published panel snapshot to draw a frame.
+         * @details The next snapshot published carries the lamp duty cycles accumulated since this frame, and posts
+         * the PDP8 TerminalManager so the console wakes to draw it.
+         */
+        PanelSnapshot takeFrame();
+
+        /**
+         * @brief Retrieve and clear the description of an exception, breakpoint or sanitizer trap which stopped
+         * the CPU.
+         */
+        std::optional<std::string> takeFault();
+    };
+
+} // pdp8
+
+#endif //PDP8_CPURUNNER_H
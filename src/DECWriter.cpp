@@ -14,6 +14,7 @@
  */
 
 #include "DECWriter.h"
+#include <array>
 #include <stdexcept>
 #include <fmt/format.h>
 #include <PDP8.h>
@@ -23,22 +24,22 @@ namespace pdp8 {
         if (device == keyboardDevice) {
             switch (opCode) {
                 case 0: // KCF
-                    keyboardFlag = false;
+                    takeKeyboard(true);
                     performInputOutput(pdp8);
                     break;
                 case 1: // KSF
+                    readInput();
                     if (keyboardFlag)
                         ++pdp8.memory.programCounter;
                     break;
                 case 4: // KRS
-                    pdp8.accumulator.setAcc(pdp8.accumulator.getAcc() | (keyboardBuffer & 0377));
+                    pdp8.accumulator.setAcc(pdp8.accumulator.getAcc() | takeKeyboard(false));
                     break;
                 case 5: // KIE
                     interruptEnable = (pdp8.accumulator.getAcc() & 01) == 01;
                     break;
                 case 6: // KRB
-                    keyboardFlag = false;
-                    pdp8.accumulator.setAcc(keyboardBuffer & 0377);
+                    pdp8.accumulator.setAcc(takeKeyboard(true));
                     performInputOutput(pdp8);
                     break;
                 default:
@@ -47,25 +48,26 @@ namespace pdp8 {
         } else if (device == printerDevice) {
             switch (opCode) {
                 case 0: // TFL
-                    printerFlag = true;
+                    setPrinterFlag(true);
                     break;
                 case 1: // TSF
                     if (printerFlag)
                         ++pdp8.memory.programCounter;
                     break;
                 case 2: // TCF
-                    printerFlag = false;
+                    setPrinterFlag(false);
                     performInputOutput(pdp8);
                     break;
                 case 4: // TPC
                     printerBuffer = static_cast<unsigned int>(pdp8.accumulator.getAscii());
                     break;
                 case 5: // TSK
+                    readInput();
                     if (printerFlag || keyboardFlag)
                         ++pdp8.memory.programCounter;
                     break;
                 case 6: // TLS
-                    printerFlag = false;
+                    setPrinterFlag(false);
                     printerBuffer = static_cast<unsigned int>(pdp8.accumulator.getAscii());
                     performInputOutput(pdp8);
                     break;
@@ -77,6 +79,46 @@ namespace pdp8 {
                                         device, keyboardDevice, printerDevice));
     }
 
+    void DECWriter::registerOperations(unsigned long deviceSel, IotOperations &operations) {
+        if (deviceSel == keyboardDevice) {
+            operations[1] = IotHandler{[](void *context, PDP8 &pdp8) {   // KSF
+                auto decWriter = static_cast<DECWriter *>(context);
+                decWriter->readInput();
+                if (decWriter->keyboardFlag)
+                    ++pdp8.memory.programCounter;
+            }, this};
+        } else if (deviceSel == printerDevice) {
+            operations[1] = IotHandler{[](void *context, PDP8 &pdp8) {   // TSF
+                auto decWriter = static_cast<DECWriter *>(context);
+                if (decWriter->printerFlag)
+                    ++pdp8.memory.programCounter;
+            }, this};
+            operations[5] = IotHandler{[](void *context, PDP8 &pdp8) {   // TSK
+                auto decWriter = static_cast<DECWriter *>(context);
+                decWriter->readInput();
+                if (decWriter->printerFlag || decWriter->keyboardFlag)
+                    ++pdp8.memory.programCounter;
+            }, this};
+        }
+    }
+
+    void DECWriter::setKeyboardFlag(bool flag) {
+        keyboardFlag = flag;
+        setInterruptRequest(keyboardDevice, flag);
+    }
+
+    unsigned int DECWriter::takeKeyboard(bool clearFlag) {
+        std::lock_guard guard{keyboardLock};
+        if (clearFlag)
+            setKeyboardFlag(false);
+        return keyboardBuffer & 0377;
+    }
+
+    void DECWriter::setPrinterFlag(bool flag) {
+        printerFlag = flag;
+        setInterruptRequest(printerDevice, flag);
+    }
+
     bool DECWriter::getInterruptRequest(unsigned long deviceSel) {
         if (deviceSel == printerDevice)
             return printerFlag;
@@ -86,67 +128,182 @@ namespace pdp8 {
     }
 
     void DECWriter::nextChar() {
-        if (!terminal->inputLineBuffer.empty()) {
+        auto connected = terminal.load();
+        if (!connected)
+            return;
+        std::lock_guard inputGuard{connected->inputLock};
+        std::lock_guard keyboardGuard{keyboardLock};
+        if (!connected->inputLineBuffer.empty()) {
             if (!keyboardFlag) {
-                auto c = terminal->inputLineBuffer[0];
+                auto c = connected->inputLineBuffer[0];
                 keyboardBuffer = static_cast<unsigned int>((u_char) c);
-                terminal->inputLineBuffer = terminal->inputLineBuffer.substr(1);
-                keyboardFlag = true;
+                connected->inputLineBuffer = connected->inputLineBuffer.substr(1);
+                setKeyboardFlag(true);
+                wakeCpu();
             }
         }
     }
 
+    void DECWriter::readInput() {
+        if (inputStream == nullptr || keyboardFlag || inputEnd)
+            return;
+        if (auto c = inputStream->get(); c != std::istream::traits_type::eof()) {
+            keyboardBuffer = c == '\n' ? '\r' : static_cast<unsigned int>(c & 0377);
+            setKeyboardFlag(true);
+        } else {
+            inputEnd = true;
+        }
+    }
+
     void DECWriter::performInputOutput(PDP8 &pdp8) {
-        if (!terminal) {
-            terminal = std::make_shared<DECWriterTerminal>();
-            terminal->inputWaiting = [this]() -> void {
+        if (outputStream == nullptr && !terminal.load()) {
+            auto connected = std::make_shared<DECWriterTerminal>();
+            connected->inputWaiting = [this]() -> void {
                 nextChar();
             };
 
-            terminal->disconnectCallback = [this]() -> void {
-                terminal.reset();
+            connected->disconnectCallback = [this]() -> void {
+                terminal.store(nullptr);
             };
 
-            terminal->setCharacterMode();
-            terminal->negotiateAboutWindowSize();
-            terminal->parseInput();
+            connected->timerTick = [this, strm = &connected->out()]() -> bool {
+                printOutput(*strm);
+                return true;
+            };
 
-            terminal->out() << fmt::format("\033c"); terminal->out().flush();
-            terminal->out() << fmt::format("\033[1;1H"); terminal->out().flush();
-            terminal->out() << fmt::format("\033]0;DECWriter\007"); terminal->out().flush();
-            pdp8.terminalManager.terminalQueue = terminal;
-        }
+            connected->setCharacterMode();
+            connected->negotiateAboutWindowSize();
+            connected->parseInput();
 
-        if (!printerFlag) {
-            terminal->out().put(static_cast<char>(printerBuffer & 0xFF));
-            if (printerBuffer == '\r')
-                terminal->out().put('\n');
-            terminal->out().flush();
-            printerFlag = true;
+            connected->out() << fmt::format("\033c"); connected->out().flush();
+            connected->out() << fmt::format("\033[1;1H"); connected->out().flush();
+            connected->out() << fmt::format("\033]0;DECWriter\007"); connected->out().flush();
+            terminal.store(connected);
+            pdp8.terminalManager.queueTerminal(connected);
         }
 
-        if (!keyboardFlag) {
+        if (!printerFlag && !printerBusy)
+            startPrinting(pdp8);
+
+        if (!keyboardFlag && inputStream == nullptr) {
             nextChar();
         }
     }
 
+    void DECWriter::startPrinting(PDP8 &pdp8) {
+        printerBusy = true;
+        printerHeld = !queueCharacter(pdp8);
+        if (printCycles == 0 && !printerHeld)
+            printerDone(pdp8, pdp8.getCycleCount());    // No print rate, the character is done once queued.
+        else
+            schedulePrinter(pdp8, pdp8.getCycleCount() + printCycles);
+    }
+
+    void DECWriter::schedulePrinter(PDP8 &pdp8, EventScheduler::cycle_t when) {
+        printerDue = when;
+        pdp8.scheduler.schedule(when, [this, &pdp8](EventScheduler::cycle_t due) {
+            printerDone(pdp8, due);
+        });
+    }
+
+    bool DECWriter::queueCharacter(PDP8 &pdp8) {
+        auto c = static_cast<char>(printerBuffer & 0xFF);
+        if (outputStream != nullptr) {
+            outputStream->put(c);
+            return true;
+        }
+
+        std::size_t length = c == '\r' ? 2 : 1;
+        if (printerOutput.capacity() - printerOutput.size() < length)
+            return false;
+
+        printerOutput.push(c);
+        if (c == '\r')
+            printerOutput.push('\n');
+
+        // Only wake the terminal when the buffer was empty, otherwise it is already draining.
+        if (printerOutput.size() <= length)
+            pdp8.terminalManager.post();
+        return true;
+    }
+
+    void DECWriter::printerDone(PDP8 &pdp8, EventScheduler::cycle_t due) {
+        if (printerHeld)
+            printerHeld = !queueCharacter(pdp8);
+        if (printerHeld) {
+            schedulePrinter(pdp8, due + std::max(printCycles, HeldCycles));
+            return;
+        }
+        printerBusy = false;
+        setPrinterFlag(true);
+    }
+
+    void DECWriter::printOutput(std::ostream &strm) {
+        std::array<char, 1024> chunk{};
+        bool written{false};
+        while (auto count = printerOutput.pop(chunk)) {
+            strm.write(chunk.data(), static_cast<std::streamsize>(count));
+            written = true;
+        }
+        if (written)
+            strm.flush();
+    }
+
+    void DECWriter::serialize(SnapshotWriter &writer) const {
+        std::lock_guard guard{keyboardLock};
+        writer.writeWord(keyboardBuffer);
+        writer.writeWord(printerBuffer);
+        writer.writeFlag(interruptEnable);
+        writer.writeFlag(keyboardFlag);
+        writer.writeFlag(printerFlag);
+        writer.writeFlag(printerBusy);
+        writer.writeFlag(printerHeld);
+        writer.writeCount(printerDue);
+    }
+
+    void DECWriter::deserialize(PDP8 &pdp8, SnapshotReader &reader) {
+        std::lock_guard guard{keyboardLock};
+        keyboardBuffer = reader.readWord();
+        printerBuffer = reader.readWord();
+        interruptEnable = reader.readFlag();
+        setKeyboardFlag(reader.readFlag());
+        setPrinterFlag(reader.readFlag());
+        printerBusy = reader.readFlag();
+        printerHeld = reader.readFlag();
+        printerDue = reader.readCount();
+        if (printerBusy)
+            schedulePrinter(pdp8, printerDue);
+    }
+
+    std::shared_ptr<IOTDevice> DECWriter::clone() const {
+        auto decWriter = std::make_shared<DECWriter>(keyboardDevice, printerDevice);
+        decWriter->setPrintRate(printRate);
+        decWriter->inputStream = inputStream;
+        decWriter->outputStream = outputStream;
+        decWriter->inputEnd = inputEnd;
+        return decWriter;
+    }
+
     bool DECWriter::getServiceRequest(unsigned long deviceSel) {
-        if (deviceSel == keyboardDevice)
+        if (deviceSel == keyboardDevice) {
+            readInput();
             return keyboardFlag;
-        else if (deviceSel == printerDevice)
+        } else if (deviceSel == printerDevice)
             return printerFlag;
         return false;
     }
 
     void DECWriter::setServiceRequest(unsigned long deviceSel) {
         if (deviceSel == keyboardDevice)
-            keyboardFlag = true;
+            setKeyboardFlag(true);
         else if (deviceSel == printerDevice)
-            printerFlag = true;
+            setPrinterFlag(true);
+        wakeCpu();
     }
 
     int DECWriterTerminal::selected(bool selectedRead, bool ) {
         if (selectedRead) {
+            std::lock_guard guard{inputLock};
             parseInput(true);
             inputBufferChanged();
         }
@@ -18,9 +18,14 @@
 #ifndef PDP8_DECWRITER_H
 #define PDP8_DECWRITER_H
 
+#include <EventScheduler.h>
 #include <IOTDevice.h>
+#include <RingBuffer.h>
 #include <Terminal.h>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <mutex>
 
 namespace pdp8 {
 
@@ -29,6 +34,7 @@ namespace pdp8 {
 
     protected:
         std::function<void()> inputWaiting{};
+        std::recursive_mutex inputLock{};           ///< Guards inputLineBuffer against the CPU thread.
 
     public:
         DECWriterTerminal() : TelnetTerminal() {}
@@ -43,21 +49,49 @@ namespace pdp8 {
 
     /**
      * @class DECWriter
+     * @details Printed characters are queued in a ring buffer which the terminal service thread drains in large
+     * writes. TLS schedules an event on the PDP8 EventScheduler which raises the printer flag printCycles of
+     * emulated time later, or later still if the ring buffer is full, so output is timed the same on every run.
+     *
+     * Typed characters arrive on the terminal service thread while the program reads them on the CPU thread. The
+     * keyboard flag and buffer change together under keyboardLock, so a character can not arrive between KRB
+     * clearing the flag and reading the buffer. The terminal is held in an atomic pointer and each use works on
+     * its own copy, so the terminal thread may drop it on disconnect while the CPU thread is using it.
+     *
+     * For headless use the keyboard and printer may be connected to streams with attachStreams() instead of a
+     * terminal. The keyboard then reads a character when the program tests the keyboard flag.
      */
     class DECWriter : public IOTDevice {
     public:
-        std::shared_ptr<DECWriterTerminal> terminal{};
+        static constexpr std::size_t PrinterBufferSize = 4096;
+
+        /**
+         * @brief The default print rate, that of the LA36 DECwriter II, in characters per second.
+         */
+        static constexpr unsigned int DefaultPrintRate = 30;
+
+        std::atomic<std::shared_ptr<DECWriterTerminal>> terminal{};
         TerminalSocket terminalSocket{};
 
         unsigned int keyboardDevice{3};
         unsigned int printerDevice{4};
 
-        unsigned int keyboardBuffer{};
+        unsigned int keyboardBuffer{};              ///< Guarded by keyboardLock while a terminal is connected.
         unsigned int printerBuffer{};
 
         bool interruptEnable{false};
         bool printerFlag{true};
-        bool keyboardFlag{false};
+        std::atomic_bool keyboardFlag{false};
+
+        /**
+         * @brief The emulated time to print a character, 0 if the print rate is not limited.
+         */
+        EventScheduler::cycle_t printCycles{EventScheduler::cycles(std::chrono::seconds{1}) / DefaultPrintRate};
+
+        /**
+         * @brief How long a character waiting for space in the printer buffer waits before trying again.
+         */
+        static constexpr EventScheduler::cycle_t HeldCycles = EventScheduler::cycles(std::chrono::milliseconds{1});
 
         DECWriter() = default;
         DECWriter(unsigned int keyDev, unsigned int prnDev) : DECWriter() {
@@ -77,7 +111,121 @@ namespace pdp8 {
 
         void setServiceRequest(unsigned long deviceSel) override;
 
+        void registerOperations(unsigned long deviceSel, IotOperations &operations) override;
+
+        /**
+         * @brief Write the flags, buffers and printer state. Output not yet drained to the terminal is not saved.
+         */
+        void serialize(SnapshotWriter &writer) const override;
+
+        void deserialize(PDP8 &pdp8, SnapshotReader &reader) override;
+
+        /**
+         * @brief A DECWriter at the same device select codes and print rate.
+         * @details The clone is not connected to the terminal. It shares any streams connected with
+         * attachStreams(), call attachStreams() on the clone to give the forked machine its own console.
+         */
+        [[nodiscard]] std::shared_ptr<IOTDevice> clone() const override;
+
         void nextChar();
+
+        /**
+         * @brief Set the print rate, call on the CPU thread.
+         * @param charactersPerSecond The characters printed per second of emulated time, 0 to print each character
+         * as soon as it is sent.
+         */
+        void setPrintRate(unsigned int charactersPerSecond) {
+            printRate = charactersPerSecond;
+            printCycles = charactersPerSecond ? EventScheduler::cycles(std::chrono::seconds{1}) / charactersPerSecond
+                                              : 0;
+        }
+
+        /**
+         * @brief The print rate in characters per second, 0 if it is not limited.
+         */
+        [[nodiscard]] unsigned int getPrintRate() const {
+            return printRate;
+        }
+
+        /**
+         * @brief Write the buffered printer output to a stream, called on the terminal service thread.
+         */
+        void printOutput(std::ostream &strm);
+
+        /**
+         * @brief Connect the keyboard and printer to streams instead of a terminal.
+         * @details Newlines read are given to the program as carriage returns. The streams must outlive the
+         * DECWriter.
+         * @param input The keyboard input.
+         * @param output The printer output.
+         */
+        void attachStreams(std::istream &input, std::ostream &output) {
+            inputStream = &input;
+            outputStream = &output;
+        }
+
+        /**
+         * @brief True if the keyboard is connected to a stream which has no more input.
+         */
+        [[nodiscard]] bool inputEnded() const {
+            return inputEnd;
+        }
+
+    protected:
+        unsigned int printRate{DefaultPrintRate};
+
+        mutable std::mutex keyboardLock{};          ///< Guards keyboardBuffer and keyboardFlag changes.
+
+        /**
+         * @brief Clear the keyboard flag and read the keyboard buffer, as KRB does, in one step.
+         */
+        unsigned int takeKeyboard(bool clearFlag);
+
+        std::istream *inputStream{nullptr};
+        std::ostream *outputStream{nullptr};
+        bool inputEnd{false};
+
+        /**
+         * @brief If the keyboard is connected to a stream and the keyboard flag is clear, read the next character.
+         */
+        void readInput();
+
+        RingBuffer<char, PrinterBufferSize> printerOutput{};
+        bool printerBusy{false};        ///< A character is being printed.
+        bool printerHeld{false};        ///< The character being printed is waiting for space in printerOutput.
+        EventScheduler::cycle_t printerDue{0};      ///< The cycle count the printerDone() event is due at.
+
+        /**
+         * @brief Start printing the character in printerBuffer.
+         */
+        void startPrinting(PDP8 &pdp8);
+
+        /**
+         * @brief Queue the character in printerBuffer for the terminal.
+         * @return False if there is not room in printerOutput.
+         */
+        bool queueCharacter(PDP8 &pdp8);
+
+        /**
+         * @brief Schedule the printerDone() event.
+         */
+        void schedulePrinter(PDP8 &pdp8, EventScheduler::cycle_t when);
+
+        /**
+         * @brief The event which ends printing a character, due printCycles after it started.
+         * @details If the character is still waiting for space in printerOutput the event is scheduled again.
+         */
+        void printerDone(PDP8 &pdp8, EventScheduler::cycle_t due);
+
+        /**
+         * @brief Set the keyboard flag and its interrupt request line.
+         */
+        void setKeyboardFlag(bool flag);
+
+        /**
+         * @brief Set the printer flag and its interrupt request line.
+         */
+        void setPrinterFlag(bool flag);
     };
 
 } // pdp8
@@ -14,19 +14,17 @@
  */
 
 #include "DK8_EA.h"
-#include <chrono>
-
-using namespace std::chrono_literals;
-
 namespace pdp8 {
 
     void DK8_EA::operation(PDP8 &pdp8, unsigned int, unsigned int opCode) {
         switch (opCode) {
             case 1: // CLEI
                 enable_interrupt = true;
+                setInterruptRequest(getInterruptRequest(0));
                 break;
             case 2: // CLDI
                 enable_interrupt = false;
+                setInterruptRequest(false);
                 break;
             case 3: // CLSK
                 if (getClockFlag())
@@ -38,6 +36,15 @@ namespace pdp8 {
         }
     }
 
+    void DK8_EA::registerOperations(unsigned long , IotOperations &operations) {
+        operations[3] = IotHandler{[](void *context, PDP8 &pdp8) {   // CLSK
+            auto dk8ea = static_cast<DK8_EA *>(context);
+            if (dk8ea->getClockFlag())
+                ++pdp8.memory.programCounter;
+            dk8ea->setClockFlag(false);
+        }, this};
+    }
+
     bool DK8_EA::getInterruptRequest(unsigned long ) {
         return getClockFlag() && enable_interrupt;
     }
@@ -48,16 +55,47 @@ namespace pdp8 {
 
     void DK8_EA::setClockFlag(bool flag) {
         clock_flag = flag;
+        setInterruptRequest(flag && enable_interrupt);
+        if (flag)
+            wakeCpu();
+    }
+
+    DK8_EA::DK8_EA(bool runClock) : runClock(runClock) {}
+
+    void DK8_EA::attached(PDP8 &pdp8, unsigned long ) {
+        if (runClock && !ticking) {
+            ticking = true;
+            scheduleTick(pdp8.scheduler, pdp8.getCycleCount() + TickCycles);
+        }
+    }
+
+    void DK8_EA::scheduleTick(EventScheduler &scheduler, EventScheduler::cycle_t when) {
+        nextTick = when;
+        scheduler.schedule(when, [this, &scheduler](EventScheduler::cycle_t due) {
+            setClockFlag(true);
+            scheduleTick(scheduler, due + TickCycles);
+        });
+    }
+
+    void DK8_EA::serialize(SnapshotWriter &writer) const {
+        writer.writeFlag(clock_flag);
+        writer.writeFlag(enable_interrupt);
+        writer.writeFlag(ticking);
+        writer.writeCount(nextTick);
+    }
+
+    void DK8_EA::deserialize(PDP8 &pdp8, SnapshotReader &reader) {
+        auto flag = reader.readFlag();
+        enable_interrupt = reader.readFlag();
+        setClockFlag(flag);
+        ticking = reader.readFlag();
+        nextTick = reader.readCount();
+        if (ticking)
+            scheduleTick(pdp8.scheduler, nextTick);
     }
 
-    DK8_EA::DK8_EA(bool runClock) {
-        if (runClock)
-            clock_thread = std::jthread([this](const std::stop_token& stopToken){
-                while (!stopToken.stop_requested()) {
-                    std::this_thread::sleep_for(8333500ns);
-                    this->setClockFlag(true);
-                }
-            });
+    std::shared_ptr<IOTDevice> DK8_EA::clone() const {
+        return std::make_shared<DK8_EA>(runClock);
     }
 
     bool DK8_EA::getServiceRequest(unsigned long ) {
@@ -17,22 +17,38 @@
 #include <IOTDevice.h>
 #include <PDP8.h>
 #include <SysClock.h>
-#include <thread>
 #include <mutex>
 
 namespace pdp8 {
     /**
      * @class DK8_EA
      * @brief DK8-EA Real Time Clock (Line Frequency)
+     * @details The clock flag is raised at 120 Hz of emulated time by events on the PDP8 EventScheduler, so the
+     * ticks fall on the same instructions on every run however fast the host is.
      */
     class DK8_EA : public IOTDevice {
+    public:
+        static constexpr std::chrono::nanoseconds TickPeriod{1'000'000'000 / 120};
+
+        static constexpr EventScheduler::cycle_t TickCycles = EventScheduler::cycles(TickPeriod);
+
     protected:
         std::atomic_bool clock_flag{false};
-        std::jthread clock_thread;
+        bool runClock{true};
+        bool ticking{false};            ///< Tick events have been scheduled.
+        EventScheduler::cycle_t nextTick{0};    ///< The cycle count the next tick is due at.
+
+        /**
+         * @brief Schedule the next tick, which raises the clock flag and schedules the one after.
+         */
+        void scheduleTick(EventScheduler &scheduler, EventScheduler::cycle_t when);
 
     public:
-        bool enable_interrupt{false};
+        std::atomic_bool enable_interrupt{false};
 
+        /**
+         * @param runClock If false the clock does not tick, the flag is only raised by setServiceRequest().
+         */
         explicit DK8_EA(bool runClock = true);
 
         DK8_EA(const DK8_EA&) = delete;
@@ -50,6 +66,16 @@ namespace pdp8 {
 
         void setServiceRequest(unsigned long deviceSel) override;
 
+        void registerOperations(unsigned long deviceSel, IotOperations &operations) override;
+
+        void attached(PDP8 &pdp8, unsigned long deviceSel) override;
+
+        void serialize(SnapshotWriter &writer) const override;
+
+        void deserialize(PDP8 &pdp8, SnapshotReader &reader) override;
+
+        [[nodiscard]] std::shared_ptr<IOTDevice> clone() const override;
+
         bool getClockFlag();
 
         void setClockFlag(bool flag);
@@ -0,0 +1,145 @@
+/*
+ * DK8_EP.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file DK8_EP.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "DK8_EP.h"
+#include <PDP8.h>
+
+namespace pdp8 {
+
+    uint64_t DK8_EP::emulatedTime(const PDP8 &pdp8) {
+        return pdp8.getCycleCount() * static_cast<uint64_t>(EventScheduler::CycleTime.count());
+    }
+
+    unsigned int DK8_EP::counterAt(uint64_t time) const {
+        auto ns = period();
+        if (ns == 0 || time <= baseTime)
+            return baseCount;
+        return static_cast<unsigned int>((baseCount + (time - baseTime) / ns) % CounterModulus);
+    }
+
+    void DK8_EP::setEnable(PDP8 &pdp8, unsigned int value) {
+        auto now = emulatedTime(pdp8);
+        auto count = counterAt(now);
+        enable = value & 07777u;
+        restart(pdp8, now, count);
+        setInterruptRequest(getInterruptRequest(0));
+    }
+
+    void DK8_EP::restart(PDP8 &pdp8, uint64_t time, unsigned int count) {
+        baseTime = time;
+        baseCount = count;
+        scheduleOverflow(pdp8);
+    }
+
+    void DK8_EP::scheduleOverflow(PDP8 &pdp8) {
+        ++generation;
+        if (auto ns = period(); ns != 0) {
+            auto overflowTime = baseTime + (CounterModulus - baseCount) * ns;
+            auto cycleTime = static_cast<uint64_t>(EventScheduler::CycleTime.count());
+            auto due = (overflowTime + cycleTime - 1) / cycleTime;
+            pdp8.scheduler.schedule(due, [this, &pdp8, event = generation, overflowTime](EventScheduler::cycle_t) {
+                if (event == generation)
+                    overflow(pdp8, overflowTime);
+            });
+        }
+    }
+
+    void DK8_EP::overflow(PDP8 &pdp8, uint64_t time) {
+        setStatus(status | Overflow);
+        auto reload = mode() == Mode::Reload || mode() == Mode::EventReload;
+        restart(pdp8, time, reload ? buffer : 0u);
+    }
+
+    void DK8_EP::setStatus(unsigned int value) {
+        status = value;
+        setInterruptRequest(getInterruptRequest(0));
+        if (value)
+            wakeCpu();
+    }
+
+    void DK8_EP::serialize(SnapshotWriter &writer) const {
+        writer.writeWord(enable);
+        writer.writeWord(buffer);
+        writer.writeWord(status);
+        writer.writeCount(baseTime);
+        writer.writeWord(baseCount);
+    }
+
+    void DK8_EP::deserialize(PDP8 &pdp8, SnapshotReader &reader) {
+        enable = reader.readWord();
+        buffer = reader.readWord();
+        auto flags = reader.readWord();
+        baseTime = reader.readCount();
+        baseCount = reader.readWord() % CounterModulus;
+        setStatus(flags);
+        scheduleOverflow(pdp8);
+    }
+
+    std::shared_ptr<IOTDevice> DK8_EP::clone() const {
+        return std::make_shared<DK8_EP>();
+    }
+
+    void DK8_EP::operation(PDP8 &pdp8, unsigned int, unsigned int opCode) {
+        auto ac = static_cast<unsigned int>(pdp8.accumulator.getAcc());
+        switch (opCode) {
+            case 0: // CLZE
+                setEnable(pdp8, enable & ~ac);
+                break;
+            case 1: // CLSK
+                if (status)
+                    ++pdp8.memory.programCounter;
+                break;
+            case 2: // CLDE
+                setEnable(pdp8, enable | ac);
+                break;
+            case 3: // CLAB
+                buffer = ac;
+                restart(pdp8, emulatedTime(pdp8), buffer);
+                break;
+            case 4: // CLEN
+                pdp8.accumulator.setAcc(enable);
+                break;
+            case 5: // CLSA
+                pdp8.accumulator.setAcc(status);
+                setStatus(0);
+                break;
+            case 6: // CLBA
+                pdp8.accumulator.setAcc(buffer);
+                break;
+            case 7: // CLCA
+                buffer = counterAt(emulatedTime(pdp8));
+                pdp8.accumulator.setAcc(buffer);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void DK8_EP::registerOperations(unsigned long, IotOperations &operations) {
+        operations[1] = IotHandler{[](void *context, PDP8 &pdp8) {   // CLSK
+            if (static_cast<DK8_EP *>(context)->status)
+                ++pdp8.memory.programCounter;
+        }, this};
+    }
+
+    bool DK8_EP::getInterruptRequest(unsigned long) {
+        return status != 0 && (enable & InterruptEnable) != 0;
+    }
+
+    bool DK8_EP::getServiceRequest(unsigned long) {
+        return status != 0;
+    }
+
+    void DK8_EP::setServiceRequest(unsigned long) {
+        setStatus(status | Overflow);
+    }
+
+} // pdp8
@@ -0,0 +1,164 @@
+/*
+ * DK8_EP.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file DK8_EP.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief DK8-EP Programmable Real Time Clock.
+ * @details See DEC_8E-HR2B-D-DK8-EP in DEC Documents. A 12 bit counter counts up at a rate selected by the enable
+ * register and raises the overflow flag when it wraps, optionally reloading from the buffer register. The counter
+ * is not stepped count by count, its value is computed from emulated time when the program reads it and a single
+ * event on the PDP8 EventScheduler is due at the next overflow. High rates cost nothing until the counter
+ * overflows, and no host thread is involved.
+ */
+
+#ifndef PDP8_DK8_EP_H
+#define PDP8_DK8_EP_H
+
+#include <IOTDevice.h>
+#include <EventScheduler.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace pdp8 {
+
+    /**
+     * @class DK8_EP
+     * @brief DK8-EP Programmable Real Time Clock
+     * @details
+     * | IOT  | Mnemonic | Operation                                               |
+     * |------|----------|---------------------------------------------------------|
+     * | 6130 | CLZE     | Clear the enable register bits set in AC.               |
+     * | 6131 | CLSK     | Skip if a status flag is set.                           |
+     * | 6132 | CLDE     | Set the enable register bits set in AC.                 |
+     * | 6133 | CLAB     | AC to the buffer and counter.                           |
+     * | 6134 | CLEN     | Enable register to AC.                                  |
+     * | 6135 | CLSA     | Status to AC, then clear the status.                    |
+     * | 6136 | CLBA     | Buffer to AC.                                           |
+     * | 6137 | CLCA     | Counter to the buffer and AC.                           |
+     *
+     * The external event inputs have no source in the emulator, so the event modes count as the matching
+     * overflow modes.
+     */
+    class DK8_EP : public IOTDevice {
+    public:
+        static constexpr unsigned int InterruptEnable = 04000;  ///< Enable register: interrupt on a status flag.
+        static constexpr unsigned int ModeMask = 03000;         ///< Enable register: counter mode.
+        static constexpr unsigned int ModeShift = 9;
+        static constexpr unsigned int RateMask = 00700;         ///< Enable register: counter rate.
+        static constexpr unsigned int RateShift = 6;
+
+        static constexpr unsigned int Overflow = 04000;         ///< Status register: the counter overflowed.
+
+        /**
+         * @brief The counter modes, selected by the enable register ModeMask bits.
+         */
+        enum class Mode : unsigned int {
+            FreeRunning = 0,    ///< The counter runs on from zero after an overflow.
+            Reload = 1,         ///< The counter is reloaded from the buffer after an overflow.
+            Event = 2,          ///< Event capture, counts as FreeRunning.
+            EventReload = 3,    ///< Event capture with reload, counts as Reload.
+        };
+
+        /**
+         * @brief The time between counts for each rate selection, zero if the counter does not count.
+         * @details Rate 0 stops the counter and rate 1 counts the external input, which is never driven.
+         */
+        static constexpr std::array<uint64_t, 8> RatePeriods{
+                0, 0, 10'000'000, 1'000'000, 100'000, 10'000, 1'000, 1'000'000'000 / 120
+        };
+
+        static constexpr unsigned int CounterModulus = 010000;
+
+    protected:
+        unsigned int enable{0};
+        unsigned int buffer{0};
+        std::atomic<unsigned int> status{0};
+
+        uint64_t baseTime{0};           ///< The emulated time in ns at which the counter held baseCount.
+        unsigned int baseCount{0};
+        uint64_t generation{0};         ///< Identifies the pending overflow event, older events are ignored.
+
+        static uint64_t emulatedTime(const PDP8 &pdp8);
+
+        [[nodiscard]] uint64_t period() const {
+            return RatePeriods[(enable & RateMask) >> RateShift];
+        }
+
+        [[nodiscard]] Mode mode() const {
+            return static_cast<Mode>((enable & ModeMask) >> ModeShift);
+        }
+
+        /**
+         * @brief The counter value at an emulated time.
+         */
+        [[nodiscard]] unsigned int counterAt(uint64_t time) const;
+
+        /**
+         * @brief Change the enable register, restarting the count from the current counter value.
+         */
+        void setEnable(PDP8 &pdp8, unsigned int value);
+
+        /**
+         * @brief Restart counting from a counter value at an emulated time and schedule its overflow.
+         */
+        void restart(PDP8 &pdp8, uint64_t time, unsigned int count);
+
+        /**
+         * @brief Schedule the overflow of the count started at baseTime, if the counter is running.
+         */
+        void scheduleOverflow(PDP8 &pdp8);
+
+        /**
+         * @brief The overflow event, due when the counter wraps.
+         */
+        void overflow(PDP8 &pdp8, uint64_t time);
+
+        void setStatus(unsigned int value);
+
+    public:
+        DK8_EP() = default;
+
+        DK8_EP(const DK8_EP&) = delete;
+        DK8_EP(DK8_EP&&) = delete;
+        DK8_EP& operator=(const DK8_EP&) = delete;
+        DK8_EP& operator=(DK8_EP&&) = delete;
+
+        ~DK8_EP() override = default;
+
+        void operation(PDP8 &pdp8, unsigned int device, unsigned int opCode) override;
+
+        void registerOperations(unsigned long deviceSel, IotOperations &operations) override;
+
+        bool getInterruptRequest(unsigned long deviceSel) override;
+
+        bool getServiceRequest(unsigned long deviceSel) override;
+
+        void setServiceRequest(unsigned long deviceSel) override;
+
+        void serialize(SnapshotWriter &writer) const override;
+
+        void deserialize(PDP8 &pdp8, SnapshotReader &reader) override;
+
+        [[nodiscard]] std::shared_ptr<IOTDevice> clone() const override;
+
+        [[nodiscard]] unsigned int getStatus() const {
+            return status;
+        }
+
+        [[nodiscard]] unsigned int getEnable() const {
+            return enable;
+        }
+
+        [[nodiscard]] unsigned int getBuffer() const {
+            return buffer;
+        }
+    };
+
+} // pdp8
+
+#endif //PDP8_DK8_EP_H
@@ -0,0 +1,31 @@
+/*
+ * EventScheduler.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file EventScheduler.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "EventScheduler.h"
+#include <algorithm>
+
+namespace pdp8 {
+
+    void EventScheduler::schedule(cycle_t when, Action action) {
+        events.push_back(Event{when, sequence++, std::move(action)});
+        std::ranges::push_heap(events, later);
+    }
+
+    void EventScheduler::runDue(cycle_t now) {
+        while (!events.empty() && events.front().when <= now) {
+            std::ranges::pop_heap(events, later);
+            auto event = std::move(events.back());
+            events.pop_back();
+            event.action(event.when);
+        }
+    }
+
+} // pdp8
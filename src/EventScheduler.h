@@ -0,0 +1,103 @@
+/*
+ * EventScheduler.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file EventScheduler.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Device events scheduled in emulated time.
+ * @details Emulated time is counted in cycles, the time of one instruction, by PDP8::getCycleCount(). Events are
+ * held in a min-heap on the cycle they are due. The CPU runs each batch of instructions up to the next deadline
+ * and then runs the due events, so nothing is checked per instruction. Events run on the CPU execution thread with
+ * the CPU lock held.
+ */
+
+#ifndef PDP8_EVENTSCHEDULER_H
+#define PDP8_EVENTSCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace pdp8 {
+
+    /**
+     * @class EventScheduler
+     */
+    class EventScheduler {
+    public:
+        using cycle_t = uint64_t;
+        using Action = std::function<void(cycle_t when)>;    ///< Called with the cycle count the event was due at.
+
+        static constexpr cycle_t Never = std::numeric_limits<cycle_t>::max();
+
+        /**
+         * @brief The emulated time of one cycle, a PDP-8/E memory reference instruction.
+         */
+        static constexpr std::chrono::nanoseconds CycleTime{1500};
+
+        /**
+         * @brief The number of whole cycles in an emulated duration, at least one.
+         */
+        template<class Rep, class Period>
+        static constexpr cycle_t cycles(std::chrono::duration<Rep, Period> duration) {
+            auto count = std::chrono::duration_cast<std::chrono::nanoseconds>(duration) / CycleTime;
+            return count > 0 ? static_cast<cycle_t>(count) : 1u;
+        }
+
+    protected:
+        struct Event {
+            cycle_t when;
+            uint64_t sequence;      ///< Orders events due on the same cycle by when they were scheduled.
+            Action action;
+        };
+
+        std::vector<Event> events{};
+        uint64_t sequence{0};
+
+        /**
+         * @brief Heap order, the earliest event at the front.
+         */
+        static bool later(const Event &a, const Event &b) {
+            return a.when != b.when ? a.when > b.when : a.sequence > b.sequence;
+        }
+
+    public:
+        /**
+         * @brief Schedule an action.
+         * @param when The cycle count the action is due at.
+         * @param action The action, which may schedule further events.
+         */
+        void schedule(cycle_t when, Action action);
+
+        /**
+         * @brief The cycle count the earliest event is due at, Never if there are none.
+         */
+        [[nodiscard]] cycle_t nextDeadline() const {
+            return events.empty() ? Never : events.front().when;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return events.empty();
+        }
+
+        /**
+         * @brief Run, in order, every event due at or before now, including events they schedule which are due.
+         */
+        void runDue(cycle_t now);
+
+        /**
+         * @brief Discard every event.
+         */
+        void clear() {
+            events.clear();
+        }
+    };
+
+} // pdp8
+
+#endif //PDP8_EVENTSCHEDULER_H
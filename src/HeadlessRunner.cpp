@@ -0,0 +1,281 @@
+/*
+ * HeadlessRunner.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file HeadlessRunner.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "HeadlessRunner.h"
+#include <assembler/Assembler.h>
+#include <assembler/NullStream.h>
+#include <algorithm>
+#include <fmt/format.h>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace pdp8 {
+
+    namespace {
+        /**
+         * @brief Parse a whole argument as an unsigned number in the given base.
+         */
+        unsigned long long parseNumber(const std::string &option, const std::string &argument, int base) {
+            std::size_t length{0};
+            unsigned long long value{0};
+            try {
+                value = std::stoull(argument, &length, base);
+            } catch (const std::logic_error &) {
+                length = 0;
+            }
+            if (length == 0 || length != argument.length())
+                throw std::invalid_argument(fmt::format("Invalid value for {}: {}", option, argument));
+            return value;
+        }
+    }
+
+    HeadlessOptions HeadlessRunner::parseArguments(std::span<char *const> arguments) {
+        HeadlessOptions options{};
+        for (std::size_t idx = 0; idx < arguments.size(); ++idx) {
+            std::string option{arguments[idx]};
+            if (idx + 1 >= arguments.size())
+                throw std::invalid_argument(fmt::format("Missing value for {}", option));
+            std::string argument{arguments[++idx]};
+
+            if (option == "--pal") {
+                options.palFile = argument;
+            } else if (option == "--bin") {
+                options.binFile = argument;
+            } else if (option == "--snapshot") {
+                options.snapshotFile = argument;
+            } else if (option == "--save-snapshot") {
+                options.saveSnapshotFile = argument;
+            } else if (option == "--input") {
+                options.inputFile = argument;
+            } else if (option == "--output") {
+                options.outputFile = argument;
+            } else if (option == "--budget") {
+                options.budget = parseNumber(option, argument, 10);
+            } else if (option == "--start") {
+                auto start = parseNumber(option, argument, 8);
+                if (start > 077777u)
+                    throw std::invalid_argument(fmt::format("Start address out of range: {}", argument));
+                options.start = static_cast<fast_register_t>(start);
+            } else if (option == "--engine") {
+                if (argument == "switch")
+                    options.engine = PDP8::ExecutionEngine::Switch;
+                else if (argument == "threaded")
+                    options.engine = PDP8::ExecutionEngine::Threaded;
+                else if (argument == "block")
+                    options.engine = PDP8::ExecutionEngine::Block;
+                else
+                    throw std::invalid_argument(fmt::format("Unknown engine: {}", argument));
+            } else if (option == "--timing") {
+                if (argument == "fast")
+                    options.timing = PDP8::TimingMode::FastAsPossible;
+                else if (argument == "realtime")
+                    options.timing = PDP8::TimingMode::RealTime;
+                else
+                    throw std::invalid_argument(fmt::format("Unknown timing: {}", argument));
+            } else if (option == "--clock") {
+                if (argument == "dk8ea")
+                    options.programmableClock = false;
+                else if (argument == "dk8ep")
+                    options.programmableClock = true;
+                else
+                    throw std::invalid_argument(fmt::format("Unknown clock: {}", argument));
+            } else if (option == "--trace") {
+                options.traceFile = argument;
+            } else if (option == "--trace-stream") {
+                options.traceStreamFile = argument;
+            } else if (option == "--print-rate") {
+                auto rate = parseNumber(option, argument, 10);
+                if (rate > std::numeric_limits<unsigned int>::max())
+                    throw std::invalid_argument(fmt::format("Print rate out of range: {}", argument));
+                options.printRate = static_cast<unsigned int>(rate);
+            } else if (option == "--sanitize") {
+                if (argument == "off")
+                    options.sanitize = Sanitizer::Mode::Off;
+                else if (argument == "log")
+                    options.sanitize = Sanitizer::Mode::Log;
+                else if (argument == "trap")
+                    options.sanitize = Sanitizer::Mode::Trap;
+                else
+                    throw std::invalid_argument(fmt::format("Unknown sanitize mode: {}", argument));
+            } else {
+                throw std::invalid_argument(fmt::format("Unknown option: {}", option));
+            }
+        }
+
+        if (!options.palFile.empty() + !options.binFile.empty() + !options.snapshotFile.empty() != 1)
+            throw std::invalid_argument("One of --pal, --bin or --snapshot is required.");
+        return options;
+    }
+
+    HeadlessRunner::HeadlessRunner(HeadlessOptions headlessOptions)
+            : options(std::move(headlessOptions)), pdp8(options.engine) {
+        std::istream *input = &std::cin;
+        std::ostream *output = &std::cout;
+        if (!options.inputFile.empty()) {
+            inputFile.open(options.inputFile, std::ios::binary);
+            if (!inputFile)
+                throw std::runtime_error(fmt::format("Can not open input {}", options.inputFile));
+            input = &inputFile;
+        }
+        if (!options.outputFile.empty()) {
+            outputFile.open(options.outputFile, std::ios::binary);
+            if (!outputFile)
+                throw std::runtime_error(fmt::format("Can not open output {}", options.outputFile));
+            output = &outputFile;
+        }
+
+        pdp8.setTimingMode(options.timing);
+        pdp8.setSanitizerMode(options.sanitize);
+        if (!options.traceFile.empty())
+            pdp8.enableTrace(TraceBuffer::DefaultCapacity, options.traceFile);
+        if (!options.traceStreamFile.empty())
+            pdp8.enableTraceStream(options.traceStreamFile);
+        decWriter->attachStreams(*input, *output);
+        decWriter->setPrintRate(options.printRate);
+        pdp8.attachDevice(decWriter->keyboardDevice, decWriter);
+        pdp8.attachDevice(decWriter->printerDevice, decWriter);
+        if (options.programmableClock)
+            clock = std::make_shared<DK8_EP>();
+        else
+            clock = std::make_shared<DK8_EA>();
+        pdp8.attachDevice(013, clock);
+    }
+
+    void HeadlessRunner::load() {
+        std::stringstream binary{};
+        if (!options.snapshotFile.empty()) {
+            std::ifstream snapshot{options.snapshotFile, std::ios::binary};
+            if (!snapshot)
+                throw std::runtime_error(fmt::format("Can not open {}", options.snapshotFile));
+            pdp8.restoreSnapshot(snapshot);
+        } else if (!options.palFile.empty()) {
+            std::ifstream source{options.palFile};
+            if (!source)
+                throw std::runtime_error(fmt::format("Can not open {}", options.palFile));
+
+            null_stream::NullStreamBuffer nullBuffer{};
+            std::ostream listing{&nullBuffer};
+            pdp8asm::Assembler assembler{};
+            try {
+                assembler.readProgram(source);
+                if (!assembler.pass1() || !assembler.pass2(binary, listing))
+                    throw std::runtime_error(fmt::format("Assembly of {} failed", options.palFile));
+            } catch (const std::invalid_argument &e) {
+                throw std::runtime_error(fmt::format("Assembly of {} failed: {}", options.palFile, e.what()));
+            }
+        } else {
+            std::ifstream tape{options.binFile, std::ios::binary};
+            if (!tape)
+                throw std::runtime_error(fmt::format("Can not open {}", options.binFile));
+            binary << tape.rdbuf();
+        }
+
+        if (options.snapshotFile.empty() && !pdp8.readBinaryFormat(binary) && !options.start)
+            throw std::runtime_error("The program has no start address, use --start.");
+
+        if (options.start) {
+            pdp8.memory.fieldRegister.setInstField(options.start.value() >> 12u);
+            pdp8.memory.programCounter.setProgramCounter(options.start.value() & 07777u);
+        }
+    }
+
+    HeadlessRunner::StopReason HeadlessRunner::run() {
+        auto startCount = pdp8.getInstructionCount();
+        auto startTime = std::chrono::steady_clock::now();
+        pdp8.set_run_flag(true);
+
+        while (true) {
+            auto batch = BatchSize;
+            if (options.budget) {
+                auto executed = pdp8.getInstructionCount() - startCount;
+                if (executed >= options.budget) {
+                    stopReason = StopReason::Budget;
+                    break;
+                }
+                batch = static_cast<unsigned long>(std::min<uint64_t>(BatchSize, options.budget - executed));
+            }
+
+            auto ticket = pdp8.idleWakeup->ticket();
+            auto exit = pdp8.run(batch);
+            if (exit == PDP8::RunExit::Halt) {
+                stopReason = StopReason::Halt;
+                break;
+            }
+            if (exit == PDP8::RunExit::SanitizerTrap) {
+                stopReason = StopReason::Sanitizer;
+                break;
+            }
+            if (exit == PDP8::RunExit::IdleWait) {
+                if (decWriter->inputEnded()) {
+                    stopReason = StopReason::InputEnded;
+                    break;
+                }
+                if (auto wait = pdp8.idleAdvance(); wait > std::chrono::steady_clock::duration::zero())
+                    pdp8.idleWakeup->waitFor(ticket, wait);
+            }
+            if (auto due = pdp8.pacingDeadline(); due)
+                std::this_thread::sleep_until(due.value());
+        }
+
+        pdp8.set_run_flag(false);
+        if (auto stream = pdp8.getTraceStream(); stream) {
+            tracedInstructions = stream->count();
+            if (!pdp8.disableTraceStream())
+                throw std::runtime_error(fmt::format("Writing the trace stream {} failed", options.traceStreamFile));
+        }
+        elapsed = std::chrono::steady_clock::now() - startTime;
+        instructionsRun = pdp8.getInstructionCount() - startCount;
+        if (outputFile.is_open())
+            outputFile.flush();
+        else
+            std::cout.flush();
+        return stopReason;
+    }
+
+    void HeadlessRunner::save() {
+        if (options.saveSnapshotFile.empty())
+            return;
+        std::ofstream snapshot{options.saveSnapshotFile, std::ios::binary};
+        if (!snapshot)
+            throw std::runtime_error(fmt::format("Can not open {}", options.saveSnapshotFile));
+        pdp8.saveSnapshot(snapshot);
+    }
+
+    void HeadlessRunner::report(std::ostream &strm) const {
+        static constexpr std::array<std::string_view, 4> Reasons{"Halted", "Instruction budget exhausted",
+                                                                 "End of console input",
+                                                                 "Uninitialized memory read"};
+        auto seconds = std::chrono::duration<double>(elapsed).count();
+        auto instructions = instructionsRun;
+
+        strm << fmt::format("{}\n", Reasons[static_cast<std::size_t>(stopReason)]);
+        strm << fmt::format("IF {:o} DF {:o} PC {:04o} L {:o} AC {:04o} MQ {:04o} SC {:02o}\n",
+                            pdp8.memory.fieldRegister.getInstField(), pdp8.memory.fieldRegister.getDataField(),
+                            pdp8.memory.programCounter.getProgramCounter(), pdp8.accumulator.getLink(),
+                            pdp8.accumulator.getAcc(), pdp8.mulQuotient.getWord(), pdp8.stepCounter.value);
+        strm << fmt::format("Instructions {} in {:.3f} s, {:.2f} Minst/s\n", instructions, seconds,
+                            seconds > 0.0 ? static_cast<double>(instructions) / seconds / 1.0e6 : 0.0);
+
+        if (!options.traceStreamFile.empty())
+            strm << fmt::format("Traced {} instructions to {}\n", tracedInstructions, options.traceStreamFile);
+
+        auto &sanitizer = pdp8.getSanitizer();
+        if (sanitizer.enabled()) {
+            strm << fmt::format("Uninitialized reads {}\n", sanitizer.getAccessCount());
+            for (auto &report: sanitizer.getReports())
+                strm << Sanitizer::format(report) << '\n';
+        }
+    }
+
+} // pdp8
@@ -0,0 +1,138 @@
+/*
+ * HeadlessRunner.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file HeadlessRunner.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Run a program without the console or any terminal windows.
+ * @details A PAL source, BIN tape or machine snapshot named on the command line is loaded and run at full speed
+ * until it halts, the instruction budget runs out or it waits for console input that will never come. The console
+ * DECWriter reads standard input and prints to standard output, or to files. The final registers and timing are
+ * reported when the run ends, with any reads of never written core found by --sanitize. This is the mode used for
+ * batch regression and throughput runs. A snapshot saved after booting a system lets many runs start from the
+ * booted state without repeating the boot.
+ */
+
+#ifndef PDP8_HEADLESSRUNNER_H
+#define PDP8_HEADLESSRUNNER_H
+
+#include <PDP8.h>
+#include <DECWriter.h>
+#include <DK8_EA.h>
+#include <DK8_EP.h>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace pdp8 {
+
+    /**
+     * @struct HeadlessOptions
+     * @brief The command line options of a headless run.
+     */
+    struct HeadlessOptions {
+        std::string palFile{};              ///< PAL source to assemble and load.
+        std::string binFile{};              ///< BIN format tape to load.
+        std::string snapshotFile{};         ///< Machine snapshot to restore instead of loading a program.
+        std::string saveSnapshotFile{};     ///< Where to save a snapshot when the run ends.
+        std::string inputFile{};            ///< Console keyboard input, standard input if empty.
+        std::string outputFile{};           ///< Console printer output, standard output if empty.
+        uint64_t budget{0};                 ///< The most instructions to execute, 0 for no limit.
+        std::optional<fast_register_t> start{};     ///< The start address, otherwise the one on the tape.
+        PDP8::ExecutionEngine engine{PDP8::ExecutionEngine::Block};     ///< The fastest in tests/bm_Engines.
+        PDP8::TimingMode timing{PDP8::TimingMode::FastAsPossible};
+        bool programmableClock{false};      ///< Attach a DK8-EP rather than a DK8-EA at device 13.
+        Sanitizer::Mode sanitize{Sanitizer::Mode::Off};     ///< Check for reads of never written core.
+        std::string traceFile{};            ///< Where to dump the instruction trace, no trace if empty.
+        std::string traceStreamFile{};      ///< Where to stream every instruction executed, none if empty.
+        unsigned int printRate{DECWriter::DefaultPrintRate};    ///< Printer characters per second, 0 for no limit.
+    };
+
+    /**
+     * @class HeadlessRunner
+     */
+    class HeadlessRunner {
+    public:
+        /**
+         * @brief Why a headless run ended.
+         */
+        enum class StopReason {
+            Halt,               ///< The program halted.
+            Budget,             ///< The instruction budget ran out.
+            InputEnded,         ///< The program is waiting for console input after the end of the input.
+            Sanitizer,          ///< The program read core that was never written, with --sanitize trap.
+        };
+
+        static constexpr unsigned long BatchSize = 1ul << 16;   ///< Instructions executed by each PDP8::run().
+
+        static constexpr std::string_view Usage =
+                "Usage: PDP8 [--pal file | --bin file | --snapshot file] [--input file] [--output file]\n"
+                "            [--budget instructions] [--save-snapshot file]\n"
+                "            [--start octal] [--engine switch|threaded|block] [--timing fast|realtime]\n"
+                "            [--clock dk8ea|dk8ep] [--sanitize off|log|trap] [--trace file]\n"
+                "            [--trace-stream file] [--print-rate characters-per-second]\n"
+                "With no arguments the PDP8 console is started.\n";
+
+        /**
+         * @brief Parse the command line.
+         * @param arguments The arguments following the program name.
+         * @throws std::invalid_argument if the arguments are not valid.
+         */
+        static HeadlessOptions parseArguments(std::span<char *const> arguments);
+
+    protected:
+        HeadlessOptions options;
+
+        PDP8 pdp8;
+        std::shared_ptr<DECWriter> decWriter{std::make_shared<DECWriter>()};
+        std::shared_ptr<IOTDevice> clock{};
+
+        std::ifstream inputFile{};
+        std::ofstream outputFile{};
+
+        StopReason stopReason{StopReason::Halt};
+        std::chrono::steady_clock::duration elapsed{};
+        uint64_t instructionsRun{0};        ///< Instructions executed by the last run.
+        uint64_t tracedInstructions{0};     ///< Instructions written to the trace stream.
+
+    public:
+        explicit HeadlessRunner(HeadlessOptions headlessOptions);
+
+        /**
+         * @brief Load the program or restore the snapshot named by the options.
+         * @throws std::runtime_error if the program can not be read or assembled, or the snapshot restored.
+         */
+        void load();
+
+        /**
+         * @brief Save a snapshot of the machine if the options name a file for it.
+         * @throws std::runtime_error if the snapshot can not be written.
+         */
+        void save();
+
+        /**
+         * @brief Run the program from the start address until it stops.
+         */
+        StopReason run();
+
+        /**
+         * @brief Write the stop reason, registers and timing of the last run.
+         */
+        void report(std::ostream &strm) const;
+
+        [[nodiscard]] const PDP8 &getPdp8() const {
+            return pdp8;
+        }
+    };
+
+} // pdp8
+
+#endif //PDP8_HEADLESSRUNNER_H
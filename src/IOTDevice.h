@@ -14,10 +14,111 @@
 #ifndef PDP8_IOTDEVICE_H
 #define PDP8_IOTDEVICE_H
 
+#include <Snapshot.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
 namespace pdp8 {
 
     class PDP8;
 
+    /**
+     * @class IdleWakeup
+     * @brief Wakes the CPU thread when a device the program may be waiting on changes state.
+     * @details The waiter takes a ticket before it checks the device and waits for the ticket to change, so a
+     * notification between the check and the wait is not lost.
+     */
+    class IdleWakeup {
+    protected:
+        std::mutex wakeupLock{};
+        std::condition_variable changed{};
+        unsigned long sequence{0};
+
+    public:
+        /**
+         * @brief The longest wait, in case a device changes state without notifying.
+         */
+        static constexpr std::chrono::milliseconds PollInterval{100};
+
+        unsigned long ticket() {
+            std::lock_guard guard{wakeupLock};
+            return sequence;
+        }
+
+        void notify() {
+            {
+                std::lock_guard guard{wakeupLock};
+                ++sequence;
+            }
+            changed.notify_all();
+        }
+
+        /**
+         * @brief Wait until notify() has been called since the ticket was taken.
+         * @param waitTicket The value returned by ticket().
+         * @param timeout The longest time to wait.
+         * @return True if notified, false on timeout.
+         */
+        template<class Rep, class Period>
+        bool waitFor(unsigned long waitTicket, const std::chrono::duration<Rep, Period> &timeout) {
+            std::unique_lock lock{wakeupLock};
+            return changed.wait_for(lock, timeout, [this, waitTicket]() { return sequence != waitTicket; });
+        }
+    };
+
+    /**
+     * @class InterruptRequests
+     * @brief The interrupt request lines of the attached devices, one bit per device select code.
+     * @details Devices set and clear their own bits as their flags change so the CPU can test for a pending
+     * interrupt with a single load.
+     */
+    class InterruptRequests {
+    protected:
+        std::atomic<uint64_t> lines{0};
+
+    public:
+        void set(unsigned long deviceSel, bool request) {
+            auto line = uint64_t{1} << (deviceSel & 077u);
+            if (request)
+                lines.fetch_or(line, std::memory_order_release);
+            else
+                lines.fetch_and(~line, std::memory_order_release);
+        }
+
+        [[nodiscard]] bool pending() const {
+            return lines.load(std::memory_order_acquire) != 0;
+        }
+
+        [[nodiscard]] bool test(unsigned long deviceSel) const {
+            return (lines.load(std::memory_order_acquire) & (uint64_t{1} << (deviceSel & 077u))) != 0;
+        }
+    };
+
+    /**
+     * @struct IotHandler
+     * @brief A device operation called directly by PDP8::execute_iot() rather than through IOTDevice::operation().
+     */
+    struct IotHandler {
+        using Function = void (*)(void *context, PDP8 &pdp8);
+
+        Function function{nullptr};
+        void *context{nullptr};         ///< Passed to the function, normally the device.
+
+        explicit operator bool() const {
+            return function != nullptr;
+        }
+    };
+
+    /**
+     * @brief The handlers for the eight operations of one device select code.
+     */
+    using IotOperations = std::array<IotHandler, 8>;
+
     /**
      * @class IOTDevice
      */
@@ -39,6 +140,100 @@ namespace pdp8 {
         virtual bool getServiceRequest(unsigned long deviceSel) = 0;
 
         virtual void setServiceRequest(unsigned long deviceSel) = 0;
+
+        /**
+         * @brief Register handlers for operations which should bypass operation(), such as skip tests.
+         * @details Called by PDP8::attachDevice(). Operations without a handler go to operation().
+         * @param deviceSel The device select code the device is being attached at.
+         * @param operations The handlers for that device select code.
+         */
+        virtual void registerOperations(unsigned long deviceSel, IotOperations &operations) {
+            static_cast<void>(deviceSel);
+            static_cast<void>(operations);
+        }
+
+        /**
+         * @brief Called by PDP8::attachDevice() once the device is attached, for example to schedule events.
+         * @param pdp8 The CPU.
+         * @param deviceSel The device select code the device was attached at.
+         */
+        virtual void attached(PDP8 &pdp8, unsigned long deviceSel) {
+            static_cast<void>(pdp8);
+            static_cast<void>(deviceSel);
+        }
+
+        /**
+         * @brief Write the device state to a snapshot, see PDP8::saveSnapshot().
+         */
+        virtual void serialize(SnapshotWriter &writer) const {
+            static_cast<void>(writer);
+        }
+
+        /**
+         * @brief Restore the device state written by serialize(), see PDP8::restoreSnapshot().
+         * @details Called once the CPU state has been restored and its scheduler cleared. The device sets its
+         * interrupt request lines and schedules its pending events again.
+         * @throws SnapshotError if the state can not be read.
+         */
+        virtual void deserialize(PDP8 &pdp8, SnapshotReader &reader) {
+            static_cast<void>(pdp8);
+            static_cast<void>(reader);
+        }
+
+        /**
+         * @brief Create a new device of the same kind and configuration, for PDP8::fork().
+         * @details The clone is not attached and holds no state, PDP8::fork() attaches it to the forked CPU and
+         * copies the state with serialize() and deserialize(). Devices which can not be duplicated, such as those
+         * owning a host resource, return nullptr and the CPU they are attached to can not be forked.
+         */
+        [[nodiscard]] virtual std::shared_ptr<IOTDevice> clone() const {
+            return nullptr;
+        }
+
+        /**
+         * @brief Called by PDP8::attachDevice() to connect the device to the CPU at a device select code.
+         * @details The request line for the device select code is set from getInterruptRequest().
+         */
+        void attach(unsigned long deviceSel, std::shared_ptr<IdleWakeup> wakeup,
+                    const std::shared_ptr<InterruptRequests> &requests) {
+            idleWakeup.store(std::move(wakeup));
+            interruptRequests.store(requests);
+            attachedSelects.fetch_or(uint64_t{1} << (deviceSel & 077u));
+            requests->set(deviceSel, getInterruptRequest(deviceSel));
+        }
+
+    protected:
+        std::atomic<std::shared_ptr<IdleWakeup>> idleWakeup{};
+        std::atomic<std::shared_ptr<InterruptRequests>> interruptRequests{};
+        std::atomic<uint64_t> attachedSelects{0};
+
+        /**
+         * @brief Raise or lower the interrupt request line for one device select code.
+         */
+        void setInterruptRequest(unsigned long deviceSel, bool request) {
+            if (auto requests = interruptRequests.load(); requests)
+                requests->set(deviceSel, request);
+        }
+
+        /**
+         * @brief Raise or lower the interrupt request line for every device select code the device is attached at.
+         */
+        void setInterruptRequest(bool request) {
+            if (auto requests = interruptRequests.load(); requests) {
+                auto selects = attachedSelects.load();
+                for (unsigned long deviceSel = 0; selects != 0; ++deviceSel, selects >>= 1u)
+                    if (selects & 1u)
+                        requests->set(deviceSel, request);
+            }
+        }
+
+        /**
+         * @brief Wake the CPU if it is idle, call when a flag the program may be waiting on is raised.
+         */
+        void wakeCpu() {
+            if (auto wakeup = idleWakeup.load(); wakeup)
+                wakeup->notify();
+        }
     };
 
 } // pdp8
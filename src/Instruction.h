@@ -84,6 +84,57 @@ namespace pdp8 {
         }
     };
 
+    /**
+     * @brief How the operand of a predecoded instruction is addressed.
+     */
+    enum class AddressMode : uint8_t {
+        None,           ///< IOT and OPR instructions do not address memory.
+        Direct,         ///< The operand address is the effective address.
+        Indirect,       ///< The operand address holds the effective address.
+        AutoIndex,      ///< Indirect through an auto-index location, page 0 words 010-017.
+    };
+
+    /**
+     * @struct DecodedInstruction
+     * @brief An instruction word decoded in the context of the core location that holds it.
+     * @details Memory reference instructions address page 0 or the page they are located on, so the operand
+     * address can be resolved once when the word is decoded rather than on every fetch.
+     */
+    struct DecodedInstruction {
+        small_register_t word{};        ///< The instruction word.
+        small_register_t address{};     ///< The 12 bit operand address within the instruction field.
+        OpCode opCode{OpCode::AND};
+        AddressMode mode{AddressMode::None};
+        bool valid{false};              ///< False until decoded, and again when the location is written.
+
+        DecodedInstruction() = default;
+
+        /**
+         * @brief Decode an instruction.
+         * @param instruction The instruction word.
+         * @param location The 12 bit address the instruction was fetched from.
+         */
+        DecodedInstruction(small_register_t instruction, fast_register_t location) : word(instruction), valid(true) {
+            InstructionReg reg{};
+            reg.value = instruction;
+            opCode = static_cast<OpCode>(reg.getOpCode());
+            if (reg.isMemoryInstruction()) {
+                auto page = reg.getZeroPage() ? 0u : (location & 07600u);
+                address = static_cast<small_register_t>(page | reg.getAddress());
+                if (!reg.getIndirect())
+                    mode = AddressMode::Direct;
+                else if (reg.getZeroPage() && (address & 0170u) == 0010u)
+                    mode = AddressMode::AutoIndex;
+                else
+                    mode = AddressMode::Indirect;
+            }
+        }
+
+        [[nodiscard]] bool isIndirect() const {
+            return mode == AddressMode::Indirect || mode == AddressMode::AutoIndex;
+        }
+    };
+
 } // pdp8
 
 #endif //PDP8_INSTRUCTION_H
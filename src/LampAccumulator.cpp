@@ -0,0 +1,95 @@
+/*
+ * LampAccumulator.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file LampAccumulator.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "LampAccumulator.h"
+
+namespace pdp8 {
+
+    namespace {
+        /**
+         * @brief A run of lamps: the packed bit of the least significant lamp and the number of lamps.
+         */
+        struct LampField {
+            unsigned bit;
+            unsigned width;
+            bool msbFirst;      ///< Registers are drawn most significant bit on the left.
+        };
+
+        /**
+         * @brief The packed bit positions of the lamps, in PanelRenderer order.
+         */
+        constexpr std::array<LampField, 14> LampFields{{
+            {52u, 3u, true},        // DF
+            {49u, 3u, true},        // IF
+            {0u, 12u, true},        // PC
+            {12u, 12u, true},       // MA
+            {24u, 12u, true},       // MB
+            {36u, 13u, true},       // L AC
+            {64u + 12u, 5u, true},  // SC
+            {64u, 12u, true},       // MQ
+            {64u + 17u, 8u, false}, // AND .. OPR
+            {64u + 25u, 1u, false}, // Fetch
+            {64u + 26u, 1u, false}, // Execute
+            {64u + 27u, 1u, false}, // Defer
+            {64u + 28u, 2u, false}, // Ion, Pause
+            {64u + 30u, 1u, false}, // Run
+        }};
+    }
+
+    void LampAccumulator::addBatch() {
+        for (std::size_t word = 0; word < 2u; ++word) {
+            uint64_t carry = 0;
+            for (std::size_t plane = 0; plane < Planes; ++plane) {
+                auto a = planes[plane][word];
+                auto b = plane < BatchPlanes ? batch[plane][word] : uint64_t{0};
+                planes[plane][word] = a ^ b ^ carry;
+                carry = (a & b) | (carry & (a ^ b));
+                if (carry == 0 && plane >= BatchPlanes)
+                    break;
+            }
+        }
+        batch = {};
+        planeSamples += batchSamples;
+        batchSamples = 0;
+        if (planeSamples > (uint64_t{1} << Planes) - 1u - BatchSize)
+            fold();
+    }
+
+    void LampAccumulator::fold() {
+        for (unsigned bit = 0; bit < totals.size(); ++bit) {
+            uint64_t count = 0;
+            for (std::size_t plane = 0; plane < Planes; ++plane)
+                count |= ((planes[plane][bit / 64u] >> (bit % 64u)) & 1u) << plane;
+            totals[bit] += count;
+        }
+        planes = {};
+        planeSamples = 0;
+    }
+
+    bool LampAccumulator::harvest(Intensities &intensities) {
+        if (samples == 0)
+            return false;
+
+        addBatch();
+        fold();
+        std::size_t lamp = 0;
+        for (auto &field: LampFields) {
+            for (unsigned idx = 0; idx < field.width; ++idx) {
+                auto bit = field.msbFirst ? field.bit + field.width - 1u - idx : field.bit + idx;
+                intensities[lamp++] = static_cast<uint8_t>((totals[bit] * 255u + samples / 2u) / samples);
+            }
+        }
+        totals = {};
+        samples = 0;
+        return true;
+    }
+
+} // pdp8
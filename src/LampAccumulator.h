@@ -0,0 +1,135 @@
+/*
+ * LampAccumulator.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file LampAccumulator.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Front panel lamp duty cycles accumulated by the CPU between panel frames.
+ * @details Each executed instruction is sampled as two 64 bit words with one bit per lamp. The words are added
+ * into bit-sliced (vertical) counters: plane p holds bit p of every lamp's count, so one AND and one XOR per plane
+ * update all 64 lamps of a word at once. Samples go into four fixed planes, counting to 15 without a branch, which
+ * are added into the wide planes every 15 samples. The counts are only unpacked per lamp when the panel takes a
+ * frame.
+ */
+
+#ifndef PDP8_LAMPACCUMULATOR_H
+#define PDP8_LAMPACCUMULATOR_H
+
+#include <HostInterface.h>
+#include <array>
+#include <cstdint>
+
+namespace pdp8 {
+
+    /**
+     * @class LampAccumulator
+     */
+    class LampAccumulator {
+    public:
+        /**
+         * @brief The lamps in PanelRenderer order: DF, IF, PC, MA, MB, L AC, SC and MQ most significant bit first,
+         * then the eight op codes, Fetch, Execute, Defer, Ion, Pause and Run.
+         */
+        static constexpr std::size_t LampCount = 86;
+
+        static constexpr std::size_t Planes = 24;     ///< Samples held before the planes are folded into totals.
+
+        using Intensities = std::array<uint8_t, LampCount>;  ///< Duty cycles, 0 is never lit, 255 always lit.
+
+        /**
+         * @brief The register values sampled after an instruction.
+         */
+        struct Sample {
+            fast_register_t dataField;
+            fast_register_t instField;
+            fast_register_t programCounter;
+            fast_register_t memoryAddress;
+            fast_register_t memoryBuffer;
+            fast_register_t arithmetic;     ///< Link and accumulator.
+            fast_register_t stepCounter;
+            fast_register_t mulQuotient;
+            fast_register_t opCode;
+            bool deferred;                  ///< The instruction used a defer cycle.
+            bool interruptEnable;
+            bool run;
+        };
+
+    protected:
+        using Words = std::array<uint64_t, 2>;
+
+        static constexpr std::size_t BatchPlanes = 4;
+        static constexpr unsigned BatchSize = (1u << BatchPlanes) - 1u;
+
+        std::array<Words, BatchPlanes> batch{};
+        std::array<Words, Planes> planes{};
+        std::array<uint64_t, 128> totals{};
+        uint64_t samples{0};
+        uint64_t planeSamples{0};
+        unsigned batchSamples{0};
+
+        /**
+         * @brief Pack a sample, fields least significant bit first.
+         * @details Word 0 holds PC 0-11, MA 12-23, MB 24-35, L AC 36-48, IF 49-51 and DF 52-54. Word 1 holds
+         * MQ 0-11, SC 12-16, the op codes 17-24, then Fetch, Execute, Defer, Ion, Pause and Run from bit 25.
+         */
+        static Words pack(const Sample &sample) {
+            return {
+                    (sample.programCounter & 07777u)
+                    | (uint64_t{sample.memoryAddress & 07777u} << 12u)
+                    | (uint64_t{sample.memoryBuffer & 07777u} << 24u)
+                    | (uint64_t{sample.arithmetic & 017777u} << 36u)
+                    | (uint64_t{sample.instField & 07u} << 49u)
+                    | (uint64_t{sample.dataField & 07u} << 52u),
+                    (sample.mulQuotient & 07777u)
+                    | (uint64_t{sample.stepCounter & 037u} << 12u)
+                    | (uint64_t{1} << (17u + (sample.opCode & 07u)))
+                    | (uint64_t{3} << 25u)                                  // Fetch and Execute
+                    | (uint64_t{sample.deferred} << 27u)
+                    | (uint64_t{sample.interruptEnable} << 28u)
+                    | (uint64_t{sample.run} << 30u)};
+        }
+
+        /**
+         * @brief Add the batch planes into the wide planes.
+         */
+        void addBatch();
+
+        /**
+         * @brief Move the wide plane counts into totals.
+         */
+        void fold();
+
+    public:
+        void add(const Sample &sample) {
+            auto lamps = pack(sample);
+            for (std::size_t word = 0; word < lamps.size(); ++word) {
+                auto carry = lamps[word];
+                for (auto &plane: batch) {
+                    auto next = plane[word] & carry;
+                    plane[word] ^= carry;
+                    carry = next;
+                }
+            }
+            ++samples;
+            if (++batchSamples == BatchSize)
+                addBatch();
+        }
+
+        [[nodiscard]] uint64_t getSamples() const {
+            return samples;
+        }
+
+        /**
+         * @brief Get the duty cycle of every lamp since the last harvest and start a new accumulation.
+         * @param intensities Set to the duty cycles in PanelRenderer lamp order.
+         * @return False, leaving intensities unchanged, if nothing has been sampled.
+         */
+        bool harvest(Intensities &intensities);
+    };
+
+} // pdp8
+
+#endif //PDP8_LAMPACCUMULATOR_H
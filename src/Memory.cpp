@@ -16,4 +16,98 @@
 #include "Memory.h"
 
 namespace pdp8 {
+
+    const std::shared_ptr<Memory::Page> &Memory::zeroPage() {
+        static const auto page = std::make_shared<Page>();
+        return page;
+    }
+
+    Memory::Memory() {
+        clearCore();
+    }
+
+    void Memory::clearCore() {
+        initializedWords.clear();
+        programmedWords.clear();
+        pages.fill(zeroPage());
+        pageWords.fill(zeroPage()->data());
+        sharedPages.set();
+    }
+
+    void Memory::unshare(std::size_t page) {
+        // A shared page is never written in place, even if every other memory has since copied it, so a fork
+        // running on another thread only ever reads it.
+        pages[page] = std::make_shared<Page>(*pages[page]);
+        pageWords[page] = pages[page]->data();
+        sharedPages.reset(page);
+    }
+
+    void Memory::fork(Memory &parent) {
+        pages = parent.pages;
+        pageWords = parent.pageWords;
+        initializedWords = parent.initializedWords;
+        programmedWords = parent.programmedWords;
+        sharedPages.set();
+        parent.sharedPages.set();
+
+        memoryBuffer = parent.memoryBuffer;
+        programCounter = parent.programCounter;
+        fieldRegister = parent.fieldRegister;
+        memoryAddress = parent.memoryAddress;
+
+        decoded.fill(DecodedInstruction{});
+        translated.reset();
+        ++codeGeneration;
+    }
+
+    small_register_t Memory::taggedWord(std::size_t location) const {
+        auto word = coreWord(location);
+        if (initializedWords.test(location))
+            word |= 010000u;
+        if (programmedWords.test(location))
+            word |= 020000u;
+        return word;
+    }
+
+    void Memory::save(SnapshotWriter &writer) const {
+        for (std::size_t location = 0; location < CoreSize;) {
+            auto run = location + 1;
+            while (run < CoreSize && run - location < 0xFFFFu && taggedWord(run) == taggedWord(location))
+                ++run;
+            writer.writeWord(run - location);
+            writer.writeWord(taggedWord(location));
+            location = run;
+        }
+
+        writer.writeWord(memoryBuffer.value);
+        writer.writeWord(programCounter.value);
+        writer.writeWord(fieldRegister.value);
+        writer.writeWord(memoryAddress.value);
+    }
+
+    void Memory::restore(SnapshotReader &reader) {
+        clearCore();
+        for (std::size_t location = 0; location < CoreSize;) {
+            auto run = reader.readWord();
+            auto word = reader.readWord();
+            if (run == 0 || location + run > CoreSize || (word & ~037777u) != 0)
+                throw SnapshotError("Snapshot core image is damaged.");
+            auto data = static_cast<small_register_t>(word & 07777u);
+            for (auto end = location + run; location < end; ++location) {
+                if (data != 0)
+                    writable(location) = data;
+                initializedWords.assign(location, (word & 010000u) != 0);
+                programmedWords.assign(location, (word & 020000u) != 0);
+            }
+        }
+
+        memoryBuffer.value = reader.readWord() & 07777u;
+        programCounter.value = reader.readWord();
+        fieldRegister.value = reader.readWord();
+        memoryAddress.value = reader.readWord();
+
+        decoded.fill(DecodedInstruction{});
+        ++codeGeneration;
+    }
+
 } // pdp8
\ No newline at end of file
@@ -21,7 +21,14 @@
 #include <fmt/format.h>
 #include <HostInterface.h>
 #include <Register.h>
+#include <Instruction.h>
+#include <Snapshot.h>
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <bitset>
+#include <cstdint>
+#include <memory>
 #include <istream>
 
 namespace pdp8 {
@@ -156,43 +163,208 @@ namespace pdp8 {
     class MemoryBuffer : public registers::Register<memory_t<15,0>> {
     public:
         using word_t = memory_t<12,0>;
-        using init_t = memory_t<1,12>;
-        using prog_t = memory_t<1,13>;
 
         [[nodiscard]] base_type getData() const {
             return get<word_t>();
         }
 
-        [[maybe_unused]] bool getProgrammed() {
-            return get<prog_t>();
+        void setData(base_type data) {
+            set<word_t>(static_cast<unsigned short>(data));
         }
+    };
+
+    /**
+     * @class CoreBitmap
+     * @brief One bit for each core location, packed 64 to a word.
+     * @details Counting and listing marked locations work a word at a time, so they cost little even over all
+     * of core.
+     */
+    class CoreBitmap {
+    public:
+        using word_type = uint64_t;
+        static constexpr std::size_t WordBits = 64;
+        static constexpr std::size_t Size = NumberOfFields * 4096;
 
-        bool getInitialized() {
-            return get<init_t>();
+    protected:
+        std::array<word_type, Size / WordBits> words{};
+
+        static constexpr word_type bit(std::size_t location) {
+            return word_type{1} << (location % WordBits);
         }
 
-        void setData(base_type data) {
-            set<word_t>(static_cast<unsigned short>(data));
+    public:
+        [[nodiscard]] bool test(std::size_t location) const {
+            return (words[location / WordBits] & bit(location)) != 0;
+        }
+
+        void set(std::size_t location) {
+            words[location / WordBits] |= bit(location);
+        }
+
+        void reset(std::size_t location) {
+            words[location / WordBits] &= ~bit(location);
         }
 
-        void setInit(bool initialized) {
-            set<init_t>(initialized ? 1u : 0u);
+        void assign(std::size_t location, bool value) {
+            if (value)
+                set(location);
+            else
+                reset(location);
         }
 
-        void setProgrammed(bool programmed) {
-            set<prog_t>(programmed ? 1u : 0u);
+        void clear() {
+            words.fill(0);
+        }
+
+        /**
+         * @brief True if any location from first up to, but not including, last is marked.
+         */
+        [[nodiscard]] bool any(std::size_t first, std::size_t last) const {
+            while (first < last) {
+                auto offset = first % WordBits;
+                auto span = std::min(last - first, WordBits - offset);
+                auto mask = (span == WordBits ? ~word_type{0} : (word_type{1} << span) - 1) << offset;
+                if ((words[first / WordBits] & mask) != 0)
+                    return true;
+                first += span;
+            }
+            return false;
+        }
+
+        /**
+         * @brief The number of marked locations.
+         */
+        [[nodiscard]] std::size_t count() const {
+            std::size_t total{0};
+            for (auto word: words)
+                total += static_cast<std::size_t>(std::popcount(word));
+            return total;
+        }
+
+        /**
+         * @brief Call a function with each marked location, in ascending order.
+         */
+        template<class Function>
+        void forEach(Function function) const {
+            for (std::size_t idx = 0; idx < words.size(); ++idx) {
+                for (auto word = words[idx]; word != 0; word &= word - 1)
+                    function(idx * WordBits + static_cast<std::size_t>(std::countr_zero(word)));
+            }
         }
     };
 
     /**
      * @class Memory
      * @brief Contains the available core memory and provides access to it.
+     * @details Core is held in pages of 128 words which may be shared, copy on write, with forked memories.
+     * A page is copied the first time each memory writes it after a fork, so a fork only pays for the pages it
+     * writes. A shared page is never written in place, so forks may run on other threads while the parent runs.
+     * Pages never written share a single zero page.
+     *
+     * Core words hold only the 12 bit data, so reads and writes are plain loads and stores. Whether each location
+     * has been written, and whether it was written by a loader or deposit rather than the running program, is
+     * kept in the initialized and programmed bitmaps.
      */
     class Memory {
+    public:
+        static constexpr std::size_t PageSize = 0200;
+        static constexpr std::size_t CoreSize = NumberOfFields * 4096;
+        static constexpr std::size_t NumberOfPages = CoreSize / PageSize;
+
+        using Page = std::array<small_register_t, PageSize>;
+
     protected:
-        std::array<small_register_t, NumberOfFields * 4096> core{};
+        std::array<std::shared_ptr<Page>, NumberOfPages> pages{};
+
+        /**
+         * @brief The words of each page in pages, so access does not go through the shared pointers.
+         */
+        std::array<small_register_t *, NumberOfPages> pageWords{};
+
+        /**
+         * @brief Pages which may be referenced by another memory, or are the zero page, and must be copied
+         * before they are written.
+         */
+        std::bitset<NumberOfPages> sharedPages{};
+
+        CoreBitmap initializedWords{};      ///< Locations that have been written.
+        CoreBitmap programmedWords{};       ///< Locations last written by a loader or deposit.
+
+        /**
+         * @brief A core word with the initialized and programmed bits in bits 12 and 13, as stored in snapshots.
+         */
+        [[nodiscard]] small_register_t taggedWord(std::size_t location) const;
+
+        static const std::shared_ptr<Page> &zeroPage();
+
+        /**
+         * @brief Point every page at the zero page.
+         */
+        void clearCore();
+
+        /**
+         * @brief Make a shared page private to this memory by copying it.
+     * @details The page is copied even if no other memory still references it. Deciding by use count would race
+     * with a fork copying the same page on another thread.
+         */
+        void unshare(std::size_t page);
+
+        /**
+         * @brief A core location, made writable.
+         */
+        small_register_t &writable(std::size_t location) {
+            auto page = location / PageSize;
+            if (sharedPages.test(page)) [[unlikely]]
+                unshare(page);
+            return pageWords[page][location % PageSize];
+        }
+
+        [[nodiscard]] small_register_t coreWord(std::size_t location) const {
+            return pageWords[location / PageSize][location % PageSize];
+        }
+
+        /**
+         * @brief Instructions predecoded from core, one entry per core location.
+         * @details Entries are decoded on first fetch and invalidated when the location is written.
+         */
+        std::array<DecodedInstruction, NumberOfFields * 4096> decoded{};
+
+        /**
+         * @brief Locations holding instructions that have been translated into a BlockCache block.
+         * @details A write to a marked location advances codeGeneration so cached blocks are revalidated.
+         */
+        std::bitset<NumberOfFields * 4096> translated{};
+        unsigned long codeGeneration{0};
+
+        void written() {
+            decoded[memoryAddress.value].valid = false;
+            if (translated.test(memoryAddress.value))
+                ++codeGeneration;
+        }
 
     public:
+        Memory();
+
+        /**
+         * @brief Memory is forked with fork() rather than copied, so that pages are shared correctly.
+         */
+        Memory(const Memory&) = delete;
+        Memory& operator=(const Memory&) = delete;
+
+        /**
+         * @brief Share the core of another memory, copy on write, and copy its registers.
+         * @details Both memories copy a shared page when they next write it. The caller holds any lock
+         * protecting either memory.
+         * @param parent The memory to fork.
+         */
+        void fork(Memory &parent);
+
+        /**
+         * @brief The number of pages this memory holds privately, those it has written since it was forked.
+         */
+        [[nodiscard]] std::size_t privatePages() const {
+            return NumberOfPages - sharedPages.count();
+        }
 
         using base_type = MemoryBuffer::base_type;
         MemoryBuffer memoryBuffer{};
@@ -205,15 +377,21 @@ namespace pdp8 {
                 memoryAddress.setFieldAddress(field);
                 memoryAddress.setPageWordAddress(address);
                 memoryBuffer.setData(data);
-                memoryBuffer.setInit(true);
-                memoryBuffer.setProgrammed(programmed);
-                core[memoryAddress.value] = memoryBuffer.value;
+                writable(memoryAddress.value) = static_cast<small_register_t>(memoryBuffer.getData());
+                initializedWords.set(memoryAddress.value);
+                programmedWords.assign(memoryAddress.value, programmed);
+                written();
             }
         }
 
+        /**
+         * @brief Write the memory buffer to the memory address, a write by the running program.
+         * @details The programmed bit of the location is left as it is.
+         */
         void write() {
-            memoryBuffer.setInit(true);
-            core[memoryAddress.value] = memoryBuffer.value;
+            writable(memoryAddress.value) = static_cast<small_register_t>(memoryBuffer.getData());
+            initializedWords.set(memoryAddress.value);
+            written();
         }
 
         void deposit(base_type data) {
@@ -223,7 +401,7 @@ namespace pdp8 {
         }
 
         MemoryBuffer read() {
-            memoryBuffer.value = core[memoryAddress.value];
+            memoryBuffer.value = coreWord(memoryAddress.value);
             return memoryBuffer;
         }
 
@@ -244,6 +422,76 @@ namespace pdp8 {
             return pc;
         }
 
+        /**
+         * @brief Examine the instruction at the program counter and return its predecoded form.
+         * @details The registers are left as examine() leaves them. The word is decoded only if it has been
+         * written since it was last fetched.
+         * @return The predecoded instruction.
+         */
+        const DecodedInstruction &fetchDecoded() {
+            examine();
+            auto &instruction = decoded[memoryAddress.value];
+            if (!instruction.valid)
+                instruction = DecodedInstruction{memoryBuffer.getData(), memoryAddress.getPageWordAddress()};
+            return instruction;
+        }
+
+        /**
+         * @brief Read a core location without using the registers.
+         * @param location The 15 bit field and address.
+         */
+        [[nodiscard]] small_register_t peek(std::size_t location) const {
+            return coreWord(location);
+        }
+
+        /**
+         * @brief True if a core location has been written since core was cleared.
+         * @param location The 15 bit field and address.
+         */
+        [[nodiscard]] bool initialized(std::size_t location) const {
+            return initializedWords.test(location);
+        }
+
+        /**
+         * @brief True if a core location was last written by a loader or deposit.
+         * @param location The 15 bit field and address.
+         */
+        [[nodiscard]] bool programmed(std::size_t location) const {
+            return programmedWords.test(location);
+        }
+
+        [[nodiscard]] const CoreBitmap &getInitialized() const {
+            return initializedWords;
+        }
+
+        [[nodiscard]] const CoreBitmap &getProgrammed() const {
+            return programmedWords;
+        }
+
+        void markTranslated(std::size_t location) {
+            translated.set(location);
+        }
+
+        /**
+         * @brief Incremented by each write to a location marked with markTranslated().
+         */
+        [[nodiscard]] unsigned long getCodeGeneration() const {
+            return codeGeneration;
+        }
+
+        /**
+         * @brief Write core, with the initialized and programmed bits, and the memory registers to a snapshot.
+         * @details Core is run length encoded, so unused fields cost a few bytes.
+         */
+        void save(SnapshotWriter &writer) const;
+
+        /**
+         * @brief Restore core and the memory registers from a snapshot written by save().
+         * @details Predecoded instructions are discarded and cached blocks revalidated on their next use.
+         * @throws SnapshotError if the snapshot is damaged.
+         */
+        void restore(SnapshotReader &reader);
+
         void decodeAddress(const std::string_view& type) const {
             fmt::print("{} {:1o} {:04o} {:04o}\n", type, memoryAddress.getFieldAddress(),
                        memoryAddress.getPageWordAddress(), memoryBuffer.getData());
@@ -0,0 +1,135 @@
+/*
+ * OprMicrocode.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file OprMicrocode.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Operate microinstruction handlers generated at compile time.
+ * @details There are only 512 operate bit patterns, so a handler is instantiated for each one which performs
+ * exactly the sequence ordered operations that pattern selects. PDP8::execute() dispatches through OprTable
+ * instead of testing the microinstruction bits one at a time as PDP8::execute_opr() does.
+ */
+
+#ifndef PDP8_OPRMICROCODE_H
+#define PDP8_OPRMICROCODE_H
+
+#include <PDP8.h>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+namespace pdp8 {
+
+    /**
+     * @struct OprMicrocode
+     * @brief Operate microinstruction handlers, one instantiation per operate bit pattern.
+     */
+    struct OprMicrocode {
+        using Handler = void (*)(PDP8 &);
+
+        template<unsigned Bits>
+        static void group1(PDP8 &pdp8) {
+            auto &acc = pdp8.accumulator;
+            // Seq 1
+            if constexpr ((Bits & 0200) != 0) acc.setAcc(0);
+            if constexpr ((Bits & 0100) != 0) acc.setLink(0);
+            // Seq 2
+            if constexpr ((Bits & 0040) != 0) acc.setAcc(~acc.getAcc());
+            if constexpr ((Bits & 0020) != 0) acc.setLink(~acc.getLink());
+            // Seq 3
+            if constexpr ((Bits & 0001) != 0) acc.setArithmetic(acc.getArithmetic() + 1);
+            // Seq 4
+            constexpr auto rotate = Bits & 016;
+            if constexpr (rotate == 012 || rotate == 010) {
+                acc.setArithmetic((acc.getLeastSig() << 12) | (acc.getArithmetic() >> 1));
+                if constexpr (rotate == 012)
+                    acc.setArithmetic((acc.getLeastSig() << 12) | (acc.getArithmetic() >> 1));
+            } else if constexpr (rotate == 006 || rotate == 004) {
+                acc.setArithmetic((acc.getArithmetic() << 1) | acc.getLink());
+                if constexpr (rotate == 006)
+                    acc.setArithmetic((acc.getArithmetic() << 1) | acc.getLink());
+            } else if constexpr (rotate == 002) {
+                acc.setAcc((acc.getLowerNibble() << 6) | acc.getUpperNibble());
+            } else if constexpr (rotate != 000) {
+                throw std::logic_error("Group 1 OPR error.");
+            }
+        }
+
+        template<unsigned Bits>
+        static void group2(PDP8 &pdp8) {
+            auto &acc = pdp8.accumulator;
+            bool skip;
+            // Seq 1
+            if constexpr ((Bits & 010) != 0) {   // SPA, SNA, SZL and
+                skip = true;
+                if constexpr ((Bits & 0100) != 0) skip = skip && acc.getMostSig() == 0;
+                if constexpr ((Bits & 0040) != 0) skip = skip && acc.getAcc() != 0;
+                if constexpr ((Bits & 0020) != 0) skip = skip && acc.getLink() == 0;
+            } else {                            // SMA, SZA, SNL or
+                skip = false;
+                if constexpr ((Bits & 0100) != 0) skip = skip || acc.getMostSig() != 0;
+                if constexpr ((Bits & 0040) != 0) skip = skip || acc.getAcc() == 0;
+                if constexpr ((Bits & 0020) != 0) skip = skip || acc.getLink() != 0;
+            }
+            // Seq 2
+            if constexpr ((Bits & 0200) != 0) acc.setAcc(0);                               // CLA
+            // Seq 3
+            if constexpr ((Bits & 04) != 0) acc.setAcc(acc.getAcc() | pdp8.opSxReg.value);  // OSR
+            // Seq 4
+            if constexpr ((Bits & 02) != 0) pdp8.run_flag = false;                         // HLT
+            if (skip)
+                ++pdp8.memory.programCounter;
+        }
+
+        template<unsigned Bits>
+        static void group3(PDP8 &pdp8) {
+            auto &acc = pdp8.accumulator;
+            auto &mq = pdp8.mulQuotient;
+            constexpr auto code = Bits & 0721;
+            if constexpr (code == 0621) {           // CAM
+                acc.setAcc(0);
+                mq.setWord(0);
+            } else if constexpr (code == 0701 || code == 0501) {
+                if constexpr (code == 0701)         // CLA MQA
+                    acc.setAcc(0);
+                acc.setAcc(acc.getAcc() | mq.getWord());  // MQA
+            } else if constexpr (code == 0421) {    // MQL
+                mq.setWord(acc.getAcc());
+                acc.setAcc(0);
+            } else if constexpr (code == 0521) {    // SWP
+                auto ac = acc.getAcc();
+                acc.setAcc(mq.getWord());
+                mq.setWord(ac);
+            }
+        }
+
+        template<unsigned Bits>
+        static void handler(PDP8 &pdp8) {
+            if constexpr (Bits == 0)                    // NOP
+                return;
+            else if constexpr ((Bits & 0400) == 0)
+                group1<Bits>(pdp8);
+            else if constexpr ((Bits & 0401) == 0400)
+                group2<Bits>(pdp8);
+            else
+                group3<Bits>(pdp8);
+        }
+
+        template<std::size_t... Bits>
+        static constexpr std::array<Handler, sizeof...(Bits)> makeTable(std::index_sequence<Bits...>) {
+            return {{&handler<static_cast<unsigned>(Bits)>...}};
+        }
+    };
+
+    /**
+     * @brief The operate microinstruction handlers indexed by PDP8::instructionReg.getOprBits().
+     */
+    inline constexpr std::array<OprMicrocode::Handler, 512> OprTable =
+            OprMicrocode::makeTable(std::make_index_sequence<512>{});
+
+} // pdp8
+
+#endif //PDP8_OPRMICROCODE_H
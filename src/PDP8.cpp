@@ -12,7 +12,12 @@
 #include <fmt/format.h>
 #include <ranges>
 #include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 #include "PDP8.h"
+#include "OprMicrocode.h"
 
 using namespace std::chrono_literals;
 
@@ -44,24 +49,83 @@ namespace pdp8 {
         return addressSet;
     }
 
-    bool PDP8::fetch() {
-        instructionReg.value = memory.examine().getData();
-        if (memory.memoryBuffer.getInitialized()) {
-            switch (static_cast<OpCode>(instructionReg.getOpCode())) {
-                case OpCode::IOT:
-                case OpCode::OPR:
-                    break;
-                default:
-                    memory.memoryAddress.setWordAddress(instructionReg.getAddress());
-                    if (instructionReg.getZeroPage()) {
-                        memory.memoryAddress.setPageAddress(0u);
-                    }
-            }
+    void PDP8::writeTraceDump() const {
+        if (!traceBuffer || traceDumpFile.empty())
+            return;
+        std::ofstream dump{traceDumpFile, std::ios::binary};
+        try {
+            if (dump)
+                traceBuffer->dump(dump);
+        } catch (const SnapshotError &) {
+            // The CPU is stopping for another reason, which is the one to report.
+        }
+    }
+
+    void PDP8::uninitializedAccess(Sanitizer::Access access) {
+        // The program counter has moved past the instruction unless it is the instruction being fetched.
+        auto programCounter = memory.memoryAddress.value;
+        if (access == Sanitizer::Access::Read)
+            programCounter = (memory.fieldRegister.getInstField() << 12u)
+                             | ((memory.programCounter.getProgramCounter() - 1u) & 07777u);
+        if (sanitizer.record(access, memory.memoryAddress.value, programCounter)) {
+            run_flag = false;
+            sanitizerTrap = true;
+        }
+    }
+
+    void PDP8::checkedRead(Sanitizer::Access access) {
+        if (sanitizer.enabled() && !memory.initialized(memory.memoryAddress.value))
+            uninitializedAccess(access);
+        if (access == Sanitizer::Access::Read)
+            watchAccess(Breakpoints::Access::Read);
+    }
+
+    void PDP8::watchAccess(Breakpoints::Access access) {
+        auto location = memory.memoryAddress.value;
+        if (auto breakpoint = breakpoints.match(access, location, accumulator.getAcc()); breakpoint) {
+            breakpoints.record(Breakpoints::Hit{*breakpoint, fetchLocation});
+            run_flag = false;
+            breakpointStop = true;
+        }
+    }
+
+    bool PDP8::checkBreakpoint() {
+        // A watchpoint stopped the last instruction, the Block engine only looks here within a block.
+        if (breakpointStop)
+            return true;
+
+        auto location = (memory.fieldRegister.getInstField() << 12u) | memory.programCounter.getProgramCounter();
+        if (breakpointResume == location) {
+            breakpointResume.reset();
+            return false;
+        }
+        if (auto breakpoint = breakpoints.match(Breakpoints::Access::Execute, location, accumulator.getAcc());
+                breakpoint) {
+            breakpoints.record(Breakpoints::Hit{*breakpoint, location});
+            breakpointResume = location;
+            run_flag = false;
+            breakpointStop = true;
             return true;
         }
         return false;
     }
 
+    const DecodedInstruction &PDP8::fetchDecoded() {
+        auto &decoded = memory.fetchDecoded();
+        fetchLocation = memory.memoryAddress.value;
+        ++instructionCount;
+        instructionReg.value = decoded.word;
+        checkRead(Sanitizer::Access::Execute);
+        if (decoded.mode != AddressMode::None && memory.initialized(memory.memoryAddress.value))
+            memory.memoryAddress.setPageWordAddress(decoded.address);
+        return decoded;
+    }
+
+    bool PDP8::fetch() {
+        fetchDecoded();
+        return memory.initialized(memory.memoryAddress.value);
+    }
+
     /**
      * @brief Perform the defer stat for indirect addressing.
      * @details The immediate address of the operation points to a memory cell with the intended address. If
@@ -74,11 +138,13 @@ namespace pdp8 {
         if (instructionReg.getZeroPage()) {
             memory.memoryAddress.setPageAddress(0u);
         }
+        checkRead(Sanitizer::Access::Read);
         memory.read();
         // TestCode for and action autoincrement memory registers.
         if (instructionReg.getZeroPage() && (memory.memoryAddress.getPageWordAddress() & 0170u) == 0010u) {
             memory.memoryBuffer.setData(memory.memoryBuffer.getData()+1);
             memory.write();
+            checkWrite();
         }
         // Set the address in the memory address register.
         memory.memoryAddress.setPageWordAddress(memory.memoryBuffer.getData());
@@ -95,95 +161,97 @@ namespace pdp8 {
         }
     }
 
+    void PDP8::defer(const DecodedInstruction &decoded) {
+        memory.memoryAddress.setPageWordAddress(decoded.address);
+        checkRead(Sanitizer::Access::Read);
+        memory.read();
+        if (decoded.mode == AddressMode::AutoIndex) {
+            memory.memoryBuffer.setData(memory.memoryBuffer.getData()+1);
+            memory.write();
+            checkWrite();
+        }
+        memory.memoryAddress.setPageWordAddress(memory.memoryBuffer.getData());
+        if (decoded.opCode <= OpCode::DCA)
+            memory.memoryAddress.setFieldAddress(memory.fieldRegister.getDataField());
+    }
+
     void PDP8::execute() {
         switch (static_cast<OpCode>(instructionReg.getOpCode())) {
             case OpCode::AND:
-                accumulator.andOp(memory.read().getData());
+                executeAnd();
                 break;
             case OpCode::TAD:
-                accumulator.addOp(memory.read().getData());
+                executeTad();
                 break;
             case OpCode::ISZ:
-                memory.read();
-                memory.memoryBuffer.setData(memory.memoryBuffer.getData() + 1);
-                memory.write();
-                if (memory.memoryBuffer.getData() == 0)
-                    ++memory.programCounter;
+                executeIsz();
                 break;
             case OpCode::DCA:
-                memory.memoryBuffer.setData(static_cast<unsigned short>(accumulator.getAcc()));
-                memory.write();
-                accumulator.setAcc(0);
+                executeDca();
                 break;
             case OpCode::JMS:
-                memory.memoryBuffer.setData(static_cast<unsigned short>(memory.programCounter.getProgramCounter()));
-                memory.write();
-                memory.programCounter.setProgramCounter(memory.memoryAddress.getPageWordAddress() + 1);
+                executeJms();
                 break;
-            case OpCode::JMP: {
-                bool short_jmp_flag = false;
-                if (!instructionReg.getIndirect()) {
-                    if ((memory.programCounter.getProgramCounter() - 2) == memory.memoryAddress.getPageWordAddress()) {
-                        // JMP .-1
-                        wait_instruction.set(memory.read().getData());
-                        if (std::ranges::find(WaitInstructions, wait_instruction.getWord())) {
-                            idle_flag = true; // idle loop detected
-                        }
-                    } else if ((memory.programCounter.getProgramCounter() - 1) ==
-                               memory.memoryAddress.getPageWordAddress()) {
-                        // JMP .
-                        if (interrupt_enable || interrupt_delayed > 0) {
-                            interrupt_enable = true;
-                            interrupt_delayed = 0;
-                            idle_flag = short_jmp_flag = true;
-                        } else {
-                            run_flag = false; // endless loop;
-                        }
-                    }
-                }
-                if (!short_jmp_flag) {
-                    memory.programCounter.setProgramCounter(memory.memoryAddress.getPageWordAddress());
-                    interrupt_deferred = false;
-                    memory.fieldRegister.setInstField(memory.fieldRegister.getInstBuffer());
-                }
-            }
+            case OpCode::JMP:
+                executeJmp();
                 break;
             case OpCode::IOT:
                 execute_iot();
                 break;
             case OpCode::OPR:
-                execute_opr();
+                OprTable[instructionReg.getOprBits()](*this);
                 break;
         }
     }
 
+    void PDP8::executeJmp() {
+        bool short_jmp_flag = false;
+        if (!instructionReg.getIndirect()) {
+            if ((memory.programCounter.getProgramCounter() - 2) == memory.memoryAddress.getPageWordAddress()) {
+                // JMP .-1
+                wait_instruction.set(memory.read().getData());
+                if (std::ranges::find(WaitInstructions, wait_instruction.getWord()) != WaitInstructions.end()) {
+                    idle_flag = true; // idle loop detected
+                }
+            } else if ((memory.programCounter.getProgramCounter() - 1) ==
+                       memory.memoryAddress.getPageWordAddress()) {
+                // JMP .
+                if (interrupt_enable || interrupt_delayed > 0) {
+                    interrupt_enable = true;
+                    interrupt_delayed = 0;
+                    idle_flag = short_jmp_flag = true;
+                } else {
+                    run_flag = false; // endless loop;
+                }
+            }
+        }
+        if (!short_jmp_flag) {
+            memory.programCounter.setProgramCounter(memory.memoryAddress.getPageWordAddress());
+            interrupt_deferred = false;
+            memory.fieldRegister.setInstField(memory.fieldRegister.getInstBuffer());
+        }
+    }
+
     void PDP8::instructionStep() {
         std::lock_guard guard{lock};
+        cycle();
+    }
+
+    void PDP8::cycle() {
         if (run_flag || step_flag || instruction_flag) {
             switch (cycle_state) {
-                case CycleState::Interrupt:
-                    interrupt_request = false;
-                    for (auto &device: iotDevices) {
-                        interrupt_request |= device.second->getInterruptRequest(device.first);
-                    }
-                    if (interrupt_enable && interrupt_request) {
-                        interrupt_request = false;
-                    } else if (idle_flag) {
-                        unsigned long deviceSel = wait_instruction.getDeviceSel();
-                        if (auto device = iotDevices.find(deviceSel); device != iotDevices.end()) {
-                            if (device->second->getServiceRequest(deviceSel)) {
-                                cycle_state = CycleState::Fetch;
-                            } else {
-                                std::this_thread::sleep_for(10us);
-                            }
-                        } else {
-                            throw std::runtime_error(fmt::format("Waiting on unconnected device {:o} at {:04o}",
-                                                                 deviceSel, memory.programCounter.getProgramCounter()));
-                        }
-                    } else {
+                case CycleState::Interrupt: {
+                    if (scheduler.nextDeadline() <= getCycleCount())
+                        scheduler.runDue(getCycleCount());
+                    auto ticket = idleWakeup->ticket();
+                    if (interruptCheck())
                         cycle_state = CycleState::Fetch;
+                    else if (idle_flag) {
+                        if (auto wait = advanceIdleTime(); wait > std::chrono::steady_clock::duration::zero())
+                            idleWakeup->waitFor(ticket, std::min<std::chrono::steady_clock::duration>(wait, CycleIdleWait));
                     }
                     break;
+                }
                 case CycleState::Fetch:
                     fetch();
                     if (instructionReg.isIndirectInstruction())
@@ -199,6 +267,8 @@ namespace pdp8 {
                     break;
                 case CycleState::Execute:
                     execute();
+                    if (tracing)
+                        traceInstruction();
                     cycle_state = CycleState::Interrupt;
                     instruction_flag = false;
                     step_flag = false;
@@ -209,6 +279,222 @@ namespace pdp8 {
         }
     }
 
+    bool PDP8::interruptCheck() {
+        interrupt_request = interruptRequests->pending();
+        if (interrupt_enable && interrupt_request) {
+            interrupt_request = false;
+            return false;
+        } else if (idle_flag) {
+            unsigned long deviceSel = wait_instruction.getDeviceSel();
+            if (auto device = iotDispatch[deviceSel].device; device != nullptr) {
+                if (!device->getServiceRequest(deviceSel))
+                    return false;
+                idle_flag = false;
+            } else {
+                throw std::runtime_error(fmt::format("Waiting on unconnected device {:o} at {:04o}",
+                                                     deviceSel, memory.programCounter.getProgramCounter()));
+            }
+        }
+        return true;
+    }
+
+    PDP8::RunExit PDP8::runInstructions(unsigned long maxInstructions) {
+        if (!run_flag)
+            return RunExit::Halt;
+        sanitizerTrap = false;
+        breakpointStop = false;
+        if (breakpointResume
+            && breakpointResume != ((memory.fieldRegister.getInstField() << 12u)
+                                    | memory.programCounter.getProgramCounter()))
+            breakpointResume.reset();     // Execution was moved away from the breakpoint it stopped at.
+
+        // Complete an instruction left part way through by single cycle stepping.
+        unsigned long count = 0;
+        switch (cycle_state) {
+            case CycleState::Fetch:
+                fetch();
+                if (instructionReg.isIndirectInstruction())
+                    defer();
+                [[fallthrough]];
+            case CycleState::Execute:
+                execute();
+                count = 1;
+                break;
+            case CycleState::Defer:
+                defer();
+                execute();
+                count = 1;
+                break;
+            case CycleState::Interrupt:
+            case CycleState::Pause:
+                break;
+        }
+        if (count) {
+            if (tracing)
+                traceInstruction();
+            cycle_state = CycleState::Interrupt;
+            instruction_flag = step_flag = false;
+        }
+
+        // Run the engine in batches ending at the next scheduled event, then run the events that are due.
+        auto start = instructionCount - count;
+        while (true) {
+            auto cycles = getCycleCount();
+            if (scheduler.nextDeadline() <= cycles)
+                scheduler.runDue(cycles);
+
+            auto limit = maxInstructions;
+            if (auto next = scheduler.nextDeadline(); next - cycles < maxInstructions - count)
+                limit = count + static_cast<unsigned long>(next - cycles);
+
+            auto exit = runEngine(count, limit);
+            count = static_cast<unsigned long>(instructionCount - start);
+            if (exit == RunExit::Halt && sanitizerTrap)
+                return RunExit::SanitizerTrap;
+            if (exit == RunExit::Halt && breakpointStop)
+                return RunExit::Breakpoint;
+            if (exit == RunExit::Halt && traceBuffer && (instructionReg.getWord() & 07403u) == 07402u)
+                writeTraceDump();     // Stopped by HLT.
+            if (exit != RunExit::BudgetExhausted || count >= maxInstructions)
+                return exit;
+        }
+    }
+
+    PDP8::RunExit PDP8::runEngine(unsigned long count, unsigned long maxInstructions) {
+        if (profiler)
+            return runSwitch(count, maxInstructions, *profiler);
+        if (engine == ExecutionEngine::Threaded)
+            return runThreaded(count, maxInstructions);
+        if (engine == ExecutionEngine::Block)
+            return runBlocks(count, maxInstructions);
+
+        NullProfiler noProfile{};
+        return runSwitch(count, maxInstructions, noProfile);
+    }
+
+    std::chrono::steady_clock::time_point PDP8::paceTime(EventScheduler::cycle_t cycles) {
+        if (!paceCycles) {
+            paceCycles = getCycleCount();
+            paceStart = std::chrono::steady_clock::now();
+        }
+        return paceStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                EventScheduler::CycleTime * static_cast<int64_t>(cycles - paceCycles.value()));
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> PDP8::pacingDeadline() {
+        std::lock_guard guard{lock};
+        if (timingMode != TimingMode::RealTime || idle_flag)
+            return std::nullopt;
+
+        // Restart pacing if the host has fallen behind, rather than running fast to catch up.
+        auto due = paceTime(getCycleCount());
+        if (due + MaxPacingLag < std::chrono::steady_clock::now()) {
+            paceCycles.reset();
+            due = paceTime(getCycleCount());
+        }
+        return due;
+    }
+
+    std::chrono::steady_clock::duration PDP8::idleAdvance() {
+        std::lock_guard guard{lock};
+        return advanceIdleTime();
+    }
+
+    std::chrono::steady_clock::duration PDP8::advanceIdleTime() {
+        auto next = scheduler.nextDeadline();
+        auto cycles = getCycleCount();
+
+        // In real time emulated time passes with the host clock while idle, up to the next event.
+        if (timingMode == TimingMode::RealTime) {
+            auto now = std::chrono::steady_clock::now();
+            auto elapsed = (now - paceTime(cycles)) / EventScheduler::CycleTime;
+            if (elapsed > 0)
+                idleCycles += std::min(static_cast<EventScheduler::cycle_t>(elapsed), next - cycles);
+            if (next == EventScheduler::Never)
+                return IdleWakeup::PollInterval;
+            if (next > getCycleCount()) {
+                auto wait = paceTime(next) - now;
+                return std::min<std::chrono::steady_clock::duration>(wait, IdleWakeup::PollInterval);
+            }
+        } else if (next == EventScheduler::Never) {
+            return IdleWakeup::PollInterval;
+        } else if (next > cycles) {
+            idleCycles += next - cycles;
+        }
+
+        scheduler.runDue(getCycleCount());
+        return std::chrono::steady_clock::duration::zero();
+    }
+
+    template<class Profile>
+    PDP8::RunExit PDP8::runSwitch(unsigned long count, unsigned long maxInstructions, Profile &profile) {
+        for (; count < maxInstructions; ++count) {
+            if (!run_flag)
+                return RunExit::Halt;
+            if (!interruptCheck())
+                return RunExit::IdleWait;
+            if (breakpointBefore())
+                return RunExit::Breakpoint;
+            if constexpr (Profile::Enabled) {
+                auto location = (memory.fieldRegister.getInstField() << 12u) | memory.programCounter.getProgramCounter();
+                auto &decoded = fetchDecoded();
+                profile.instruction(location, decoded.word);
+                if (decoded.isIndirect()) {
+                    profile.indirect(decoded.mode == AddressMode::AutoIndex);
+                    defer(decoded);
+                }
+                if (decoded.opCode == OpCode::IOT)
+                    profile.iot(static_cast<small_register_t>(instructionReg.getDeviceSel()));
+                execute();
+                retire(decoded.isIndirect());
+            } else {
+                auto &decoded = fetchDecoded();
+                if (decoded.isIndirect())
+                    defer(decoded);
+                execute();
+                retire(decoded.isIndirect());
+            }
+        }
+        return run_flag ? RunExit::BudgetExhausted : RunExit::Halt;
+    }
+
+    Profiler &PDP8::enableProfiler() {
+        std::lock_guard guard{lock};
+        profiler = std::make_unique<Profiler>();
+        return *profiler;
+    }
+
+    std::unique_ptr<Profiler> PDP8::disableProfiler() {
+        std::lock_guard guard{lock};
+        return std::move(profiler);
+    }
+
+    PDP8::RunExit PDP8::run(unsigned long maxInstructions) {
+        std::lock_guard guard{lock};
+        return runInstructions(maxInstructions);
+    }
+
+    PDP8::RunExit PDP8::runUntil(std::chrono::steady_clock::time_point deadline) {
+        std::lock_guard guard{lock};
+        while (true) {
+            if (auto exit = runInstructions(DeadlineCheckInterval); exit != RunExit::BudgetExhausted)
+                return exit;
+            if (std::chrono::steady_clock::now() >= deadline)
+                return RunExit::BudgetExhausted;
+        }
+    }
+
+    PDP8::RunExit PDP8::step() {
+        std::lock_guard guard{lock};
+        auto running = std::exchange(run_flag, true);
+        // A step executes the instruction even if a breakpoint is set on it.
+        breakpointResume = (memory.fieldRegister.getInstField() << 12u) | memory.programCounter.getProgramCounter();
+        auto exit = runInstructions(1);
+        if (run_flag)
+            run_flag = running;
+        return exit;
+    }
+
     void PDP8::decodeInstruction() const {    // GCOVR_EXCL_START
         switch (static_cast<OpCode>(instructionReg.getOpCode())) {
             case pdp8::OpCode::IOT:
@@ -281,8 +567,19 @@ namespace pdp8 {
         } else {
             auto deviceSel = instructionReg.getDeviceSel();
             auto devOp = instructionReg.getDeviceOpr();
-            if (auto device = iotDevices.find(static_cast<unsigned int>(deviceSel)); device != iotDevices.end()) {
-                device->second->operation(*this, static_cast<unsigned int>(deviceSel), static_cast<unsigned int>(devOp));
+            auto &slot = iotDispatch[deviceSel];
+            try {
+                if (auto &handler = slot.operations[devOp]; handler)
+                    handler.function(handler.context, *this);
+                else if (slot.device != nullptr)
+                    slot.device->operation(*this, static_cast<unsigned int>(deviceSel),
+                                           static_cast<unsigned int>(devOp));
+            } catch (...) {
+                if (tracing) {
+                    traceInstruction();
+                    writeTraceDump();
+                }
+                throw;
             }
         }
         // Other IOT instructions not supported yet.
@@ -393,6 +690,179 @@ namespace pdp8 {
         memory.programCounter.setProgramCounter(RIM_LOADER_START);
     }
 
+    namespace {
+        constexpr std::string_view SnapshotMagic{"PDP8SNAP"};
+        constexpr unsigned int SnapshotVersion = 1;
+
+        /**
+         * @brief The attached devices, each once at the lowest device select code it is attached at.
+         */
+        std::vector<std::pair<unsigned long, IOTDevice *>>
+        uniqueDevices(const std::map<unsigned long, std::shared_ptr<IOTDevice>> &iotDevices) {
+            std::vector<std::pair<unsigned long, IOTDevice *>> devices{};
+            for (auto &[deviceSel, device]: iotDevices) {
+                if (std::ranges::find(devices, device.get(), &std::pair<unsigned long, IOTDevice *>::second)
+                    == devices.end())
+                    devices.emplace_back(deviceSel, device.get());
+            }
+            return devices;
+        }
+    }
+
+    void PDP8::saveSnapshot(std::ostream &strm) {
+        std::lock_guard guard{lock};
+        strm.write(SnapshotMagic.data(), static_cast<std::streamsize>(SnapshotMagic.size()));
+        SnapshotWriter writer{strm};
+        writer.writeWord(SnapshotVersion);
+        writer.writeWord(NumberOfFields);
+
+        memory.save(writer);
+        writer.writeWord(instructionReg.value);
+        writer.writeWord(accumulator.value);
+        writer.writeWord(mulQuotient.value);
+        writer.writeWord(stepCounter.value);
+        writer.writeWord(switch_register);
+        writer.writeWord(wait_instruction.value);
+
+        writer.writeWord(static_cast<unsigned int>(cycle_state));
+        writer.writeFlag(run_flag);
+        writer.writeFlag(instruction_flag);
+        writer.writeFlag(step_flag);
+        writer.writeFlag(idle_flag);
+        writer.writeFlag(interrupt_enable);
+        writer.writeFlag(interrupt_request);
+        writer.writeFlag(error_flag);
+        writer.writeFlag(interrupt_deferred);
+        writer.writeFlag(greater_than_flag);
+        writer.writeWord(static_cast<unsigned int>(interrupt_delayed));
+
+        writer.writeCount(instructionCount);
+        writer.writeCount(idleCycles);
+
+        auto devices = uniqueDevices(iotDevices);
+        writer.writeWord(devices.size());
+        for (auto &[deviceSel, device]: devices) {
+            std::ostringstream block{};
+            SnapshotWriter deviceWriter{block};
+            device->serialize(deviceWriter);
+            writer.writeWord(deviceSel);
+            writer.writeBlock(block.str());
+        }
+
+        if (!strm)
+            throw SnapshotError("Snapshot could not be written.");
+    }
+
+    void PDP8::restoreSnapshot(std::istream &strm) {
+        std::lock_guard guard{lock};
+        std::string magic(SnapshotMagic.size(), '\0');
+        if (!strm.read(magic.data(), static_cast<std::streamsize>(magic.size())) || magic != SnapshotMagic)
+            throw SnapshotError("Not a PDP8 snapshot.");
+        SnapshotReader reader{strm};
+        if (reader.readWord() != SnapshotVersion)
+            throw SnapshotError("Unsupported snapshot version.");
+        if (reader.readWord() != NumberOfFields)
+            throw SnapshotError("Snapshot memory size does not match.");
+
+        memory.restore(reader);
+        instructionReg.value = reader.readWord();
+        accumulator.value = reader.readWord();
+        mulQuotient.value = reader.readWord();
+        stepCounter.value = reader.readWord();
+        switch_register = reader.readWord();
+        wait_instruction.value = reader.readWord();
+
+        auto state = reader.readWord();
+        if (state > static_cast<unsigned int>(CycleState::Pause))
+            throw SnapshotError("Snapshot cycle state is damaged.");
+        cycle_state = static_cast<CycleState>(state);
+        run_flag = reader.readFlag();
+        instruction_flag = reader.readFlag();
+        step_flag = reader.readFlag();
+        idle_flag = reader.readFlag();
+        interrupt_enable = reader.readFlag();
+        interrupt_request = reader.readFlag();
+        error_flag = reader.readFlag();
+        interrupt_deferred = reader.readFlag();
+        greater_than_flag = reader.readFlag();
+        interrupt_delayed = reader.readWord();
+
+        instructionCount = reader.readCount();
+        idleCycles = reader.readCount();
+        scheduler.clear();
+        paceCycles.reset();
+
+        auto count = reader.readWord();
+        if (count != uniqueDevices(iotDevices).size())
+            throw SnapshotError("Snapshot devices do not match the attached devices.");
+        for (unsigned int idx = 0; idx < count; ++idx) {
+            auto deviceSel = reader.readWord();
+            auto block = reader.readBlock();
+            auto device = iotDevices.find(deviceSel);
+            if (device == iotDevices.end())
+                throw SnapshotError(fmt::format("Snapshot device {:o} is not attached.", deviceSel));
+            std::istringstream blockStream{block};
+            SnapshotReader deviceReader{blockStream};
+            device->second->deserialize(*this, deviceReader);
+            if (!deviceReader.atEnd())
+                throw SnapshotError(fmt::format("Snapshot state of device {:o} does not match.", deviceSel));
+        }
+    }
+
+    std::unique_ptr<PDP8> PDP8::fork() {
+        std::lock_guard guard{lock};
+        auto child = std::make_unique<PDP8>(engine);
+
+        child->memory.fork(memory);
+        child->instructionReg = instructionReg;
+        child->accumulator = accumulator;
+        child->mulQuotient = mulQuotient;
+        child->stepCounter = stepCounter;
+        child->switch_register = switch_register;
+        child->wait_instruction = wait_instruction;
+
+        child->cycle_state = cycle_state;
+        child->run_flag = run_flag;
+        child->instruction_flag = instruction_flag;
+        child->step_flag = step_flag;
+        child->idle_flag = idle_flag;
+        child->interrupt_enable = interrupt_enable;
+        child->interrupt_request = interrupt_request;
+        child->error_flag = error_flag;
+        child->interrupt_deferred = interrupt_deferred;
+        child->greater_than_flag = greater_than_flag;
+        child->interrupt_delayed = interrupt_delayed;
+
+        child->instructionCount = instructionCount;
+        child->idleCycles = idleCycles;
+        child->timingMode = timingMode;
+        child->sanitizer.setMode(sanitizer.getMode());
+        child->updateChecks();
+
+        std::vector<std::pair<IOTDevice *, std::shared_ptr<IOTDevice>>> clones{};
+        for (auto &[deviceSel, device]: uniqueDevices(iotDevices)) {
+            auto clone = device->clone();
+            if (!clone)
+                throw std::logic_error(fmt::format("The device at {:o} can not be forked.", deviceSel));
+            clones.emplace_back(device, std::move(clone));
+        }
+        for (auto &[deviceSel, device]: iotDevices) {
+            auto clone = std::ranges::find(clones, device.get(), &decltype(clones)::value_type::first);
+            child->attachDevice(deviceSel, clone->second);
+        }
+
+        // Discard events scheduled as the clones were attached, the copied state schedules those pending here.
+        child->scheduler.clear();
+        for (auto &[device, clone]: clones) {
+            std::stringstream state{};
+            SnapshotWriter writer{state};
+            device->serialize(writer);
+            SnapshotReader reader{state};
+            clone->deserialize(*child, reader);
+        }
+        return child;
+    }
+
     [[maybe_unused]] void PDP8::reset() {
         accumulator.setArithmetic(0);
         interrupt_delayed = 0u;
@@ -23,11 +23,23 @@
 #include <Memory.h>
 #include <Instruction.h>
 #include <Accumulator.h>
+#include <BlockCache.h>
+#include <EventScheduler.h>
+#include <LampAccumulator.h>
+#include <Profiler.h>
+#include <Breakpoints.h>
+#include <Sanitizer.h>
+#include <TraceBuffer.h>
+#include <TraceStream.h>
+#include <Snapshot.h>
 #include <atomic>
 #include <IOTDevice.h>
 #include <Terminal.h>
 #include <map>
 #include <mutex>
+#include <chrono>
+#include <filesystem>
+#include <optional>
 
 namespace pdp8 {
 
@@ -35,6 +47,9 @@ namespace pdp8 {
      * @class PDP8
      */
     class PDP8 {
+        friend struct OprMicrocode;
+        friend class BlockCache;
+
     private:
         std::mutex lock{};
         bool run_flag{false};
@@ -96,16 +111,56 @@ namespace pdp8 {
                                                                                        {07777, 0}
                                                                                }};
 
-        static constexpr std::array<small_register_t,3> WaitInstructions = {
+        static constexpr std::array<small_register_t,5> WaitInstructions = {
                 06031, // KSF
+                06041, // TSF
                 06053, // CLSC
-                06133, // CLSK
+                06131, // CLSK DK8-EP
+                06133, // CLSK DK8-EA
+        };
+
+        /**
+         * @brief The interpreter used by run() and runUntil().
+         */
+        enum class ExecutionEngine {
+            Switch,     ///< Dispatch each instruction through execute().
+            Threaded,   ///< Direct threaded dispatch, see ThreadedEngine.cpp.
+            Block,      ///< Execute straight line code as cached blocks, see BlockCache.h.
         };
 
         enum class CycleState {
             Interrupt, Fetch, Defer, Execute, Pause
         };
 
+        /**
+         * @brief The reason a batch of instructions started by run() or runUntil() ended.
+         */
+        enum class RunExit {
+            Halt,               ///< The run flag is clear, or was cleared by the last instruction.
+            Breakpoint,         ///< Execution stopped at a breakpoint.
+            SanitizerTrap,      ///< The Sanitizer in Trap mode stopped execution, see getSanitizer().
+            IdleWait,           ///< The program is waiting on a device that is not ready.
+            BudgetExhausted,    ///< The instruction budget or the deadline was reached.
+        };
+
+        /**
+         * @brief The number of instructions runUntil() executes between checks of the deadline.
+         */
+        static constexpr unsigned long DeadlineCheckInterval = 1024;
+
+        /**
+         * @brief How emulated time relates to host time.
+         */
+        enum class TimingMode {
+            RealTime,           ///< Emulated time is paced to the host clock, see pacingDeadline().
+            FastAsPossible,     ///< Instructions run at host speed, idle time skips to the next event.
+        };
+
+        /**
+         * @brief The most the host may fall behind emulated time in RealTime mode before pacing restarts.
+         */
+        static constexpr std::chrono::milliseconds MaxPacingLag{50};
+
         CycleState cycle_state{CycleState::Interrupt};
 
         bool idle_flag{false};
@@ -119,7 +174,11 @@ namespace pdp8 {
 
         small_register_t switch_register{0};
 
-        PDP8() {
+        const ExecutionEngine engine{ExecutionEngine::Switch};
+
+        PDP8() : PDP8(ExecutionEngine::Switch) {}
+
+        explicit PDP8(ExecutionEngine executionEngine) : engine(executionEngine) {
             memory.programCounter.clear();
             memory.programCounter.setProgramCounter(0200);
             memory.fieldRegister.setDataField(0);
@@ -140,10 +199,271 @@ namespace pdp8 {
         StepCounter stepCounter{};
         TerminalManager terminalManager{};
 
+        /**
+         * @brief The attached devices by device select code, add devices with attachDevice().
+         * @details The map owns the devices, IOTs are dispatched through iotDispatch.
+         */
         std::map<unsigned long, std::shared_ptr<IOTDevice>> iotDevices{};
 
+        struct IotSlot {
+            IOTDevice *device{nullptr};
+            IotOperations operations{};
+        };
+
+        /**
+         * @brief IOT dispatch indexed by the six bit device select code.
+         */
+        std::array<IotSlot, 64> iotDispatch{};
+
+        /**
+         * @brief Notified by devices when a flag the program may be idling on is raised.
+         */
+        std::shared_ptr<IdleWakeup> idleWakeup{std::make_shared<IdleWakeup>()};
+
+        /**
+         * @brief Interrupt request lines maintained by the attached devices.
+         */
+        std::shared_ptr<InterruptRequests> interruptRequests{std::make_shared<InterruptRequests>()};
+
+        /**
+         * @brief The longest a single machine cycle waits for a device while the CPU is idle.
+         */
+        static constexpr std::chrono::milliseconds CycleIdleWait{1};
+
+        /**
+         * @brief Device events in emulated time. Use only on the execution thread with the CPU lock held, for
+         * example from an IOT operation or IOTDevice::attached().
+         */
+        EventScheduler scheduler{};
+
+        /**
+         * @brief Connect a device to the CPU at a device select code.
+         * @param deviceSel The six bit device select code.
+         * @param device The device, which may be attached at more than one device select code.
+         */
+        void attachDevice(unsigned long deviceSel, const std::shared_ptr<IOTDevice> &device) {
+            auto &slot = iotDispatch.at(deviceSel);
+            slot = IotSlot{};
+            slot.device = device.get();
+            device->registerOperations(deviceSel, slot.operations);
+            device->attach(deviceSel, idleWakeup, interruptRequests);
+            iotDevices[deviceSel] = device;
+            device->attached(*this, deviceSel);
+        }
+
+        /**
+         * @brief Perform one machine cycle (Interrupt, Fetch, Defer or Execute) under control of the run,
+         * instruction and step flags.
+         */
         void instructionStep();
 
+        /**
+         * @brief Execute up to maxInstructions whole instructions while the run flag is set.
+         * @details The CPU lock is taken once for the whole batch. An instruction left partially executed
+         * by instructionStep() is completed first.
+         * @param maxInstructions The instruction budget.
+         * @return The reason execution stopped.
+         */
+        RunExit run(unsigned long maxInstructions);
+
+        /**
+         * @brief Execute whole instructions while the run flag is set until the deadline passes.
+         * @param deadline The time at which to return.
+         * @return The reason execution stopped.
+         */
+        RunExit runUntil(std::chrono::steady_clock::time_point deadline);
+
+        /**
+         * @brief Start gathering a new profile of the instructions executed by run(), runUntil() and step().
+         * @details While profiling all engines run instructions through the switch engine.
+         * @return The profiler, owned by the PDP8.
+         */
+        Profiler &enableProfiler();
+
+        /**
+         * @brief Stop profiling.
+         * @return The profile gathered, or nullptr if the profiler was not enabled.
+         */
+        std::unique_ptr<Profiler> disableProfiler();
+
+        /**
+         * @brief Check instruction fetches and operand reads for core that has never been written.
+         * @details Changing the mode discards the reports gathered so far. In Trap mode run() and runUntil()
+         * return RunExit::SanitizerTrap after the instruction that made the read, with the run flag clear.
+         */
+        void setSanitizerMode(Sanitizer::Mode mode) {
+            std::lock_guard guard{lock};
+            sanitizer.setMode(mode);
+            updateChecks();
+        }
+
+        /**
+         * @brief The sanitizer and its reports, read them while the CPU is stopped.
+         */
+        [[nodiscard]] const Sanitizer &getSanitizer() const {
+            return sanitizer;
+        }
+
+        /**
+         * @brief Set a breakpoint or watchpoint, see Breakpoints.h.
+         * @details run() and runUntil() return RunExit::Breakpoint with the run flag clear when one is hit, before
+         * the instruction for an execute breakpoint and after it for a watchpoint. Execution continued at an execute
+         * breakpoint passes over it once.
+         */
+        void setBreakpoint(const Breakpoints::Breakpoint &breakpoint) {
+            std::lock_guard guard{lock};
+            breakpoints.set(breakpoint);
+            updateChecks();
+        }
+
+        /**
+         * @brief Clear the breakpoints and watchpoints at a 15 bit location.
+         * @return True if there were any.
+         */
+        bool clearBreakpoint(fast_register_t location) {
+            std::lock_guard guard{lock};
+            auto cleared = breakpoints.clear(location);
+            updateChecks();
+            return cleared;
+        }
+
+        void clearBreakpoints() {
+            std::lock_guard guard{lock};
+            breakpoints.clear();
+            updateChecks();
+        }
+
+        /**
+         * @brief The breakpoints and the last one hit, read them while the CPU is stopped.
+         */
+        [[nodiscard]] const Breakpoints &getBreakpoints() const {
+            return breakpoints;
+        }
+
+        /**
+         * @brief Record the most recent instructions executed in a TraceBuffer.
+         * @param capacity The number of instructions kept.
+         * @param dumpFile If not empty the trace is written here when a HLT stops the CPU or an IOT throws.
+         */
+        void enableTrace(std::size_t capacity = TraceBuffer::DefaultCapacity, std::filesystem::path dumpFile = {}) {
+            std::lock_guard guard{lock};
+            traceBuffer = std::make_unique<TraceBuffer>(capacity);
+            traceDumpFile = std::move(dumpFile);
+            tracing = true;
+        }
+
+        void disableTrace() {
+            std::lock_guard guard{lock};
+            traceBuffer.reset();
+            traceDumpFile.clear();
+            tracing = traceStream != nullptr;
+        }
+
+        /**
+         * @brief Stream every instruction executed to a file, see TraceStream.h.
+         * @throws std::runtime_error if the file can not be created.
+         */
+        void enableTraceStream(const std::filesystem::path &file) {
+            std::lock_guard guard{lock};
+            traceStream.reset();
+            traceStream = std::make_unique<TraceStreamWriter>(file);
+            tracing = true;
+        }
+
+        /**
+         * @brief Stop streaming, waiting for the records added to be written.
+         * @return False if writing the trace stream failed.
+         */
+        bool disableTraceStream() {
+            std::lock_guard guard{lock};
+            auto written = !traceStream || traceStream->close();
+            traceStream.reset();
+            tracing = traceBuffer != nullptr;
+            return written;
+        }
+
+        [[nodiscard]] const TraceStreamWriter *getTraceStream() const {
+            return traceStream.get();
+        }
+
+        /**
+         * @brief The trace, which may be dumped on any thread while the CPU runs, but not while it is enabled or
+         * disabled.
+         */
+        [[nodiscard]] const TraceBuffer *getTrace() const {
+            return traceBuffer.get();
+        }
+
+        [[nodiscard]] const Profiler *getProfiler() const {
+            return profiler.get();
+        }
+
+        /**
+         * @brief The number of instructions fetched since the PDP8 was constructed.
+         */
+        [[nodiscard]] uint64_t getInstructionCount() const {
+            return instructionCount;
+        }
+
+        /**
+         * @brief Emulated time in cycles: the instructions fetched plus the idle time skipped to scheduled events.
+         */
+        [[nodiscard]] EventScheduler::cycle_t getCycleCount() const {
+            return instructionCount + idleCycles;
+        }
+
+        void setTimingMode(TimingMode mode) {
+            std::lock_guard guard{lock};
+            timingMode = mode;
+            paceCycles.reset();
+        }
+
+        [[nodiscard]] TimingMode getTimingMode() const {
+            return timingMode;
+        }
+
+        /**
+         * @brief In RealTime mode, the host time at which emulated time catches up with the instructions run.
+         * @details A runner sleeps until this time between batches. If the host falls more than MaxPacingLag
+         * behind, pacing restarts from the current time rather than running fast to catch up.
+         * @return The time, or nothing in FastAsPossible mode or while idle, when idleAdvance() keeps pace.
+         */
+        std::optional<std::chrono::steady_clock::time_point> pacingDeadline();
+
+        /**
+         * @brief Let emulated time pass while the program idles waiting on a device.
+         * @details Called by a runner when run() returns RunExit::IdleWait. In FastAsPossible mode emulated time
+         * skips to the next event and it runs. In RealTime mode emulated time keeps pace with the host clock while
+         * idle and the next event runs once its host time arrives.
+         * @return How long the runner should wait on idleWakeup before running again, zero to run at once.
+         */
+        std::chrono::steady_clock::duration idleAdvance();
+
+        /**
+         * @brief Start or stop accumulating front panel lamp duty cycles for each executed instruction.
+         */
+        void enableLampAccumulator(bool enable) {
+            std::lock_guard guard{lock};
+            if (!enable)
+                lampAccumulator.reset();
+            else if (!lampAccumulator)
+                lampAccumulator = std::make_unique<LampAccumulator>();
+        }
+
+        /**
+         * @brief Collect the lamp duty cycles accumulated since the last harvest, call on the CPU thread.
+         * @return False if the accumulator is off or nothing has executed.
+         */
+        bool harvestLamps(LampAccumulator::Intensities &intensities) {
+            return lampAccumulator && lampAccumulator->harvest(intensities);
+        }
+
+        /**
+         * @brief Execute one whole instruction whether or not the run flag is set, even at a breakpoint.
+         * @return RunExit::Halt if the instruction halted the CPU, RunExit::Breakpoint if it hit a watchpoint.
+         */
+        RunExit step();
+
         void decodeInstruction() const;
 
         /**
@@ -156,6 +476,11 @@ namespace pdp8 {
          */
         void defer();
 
+        /**
+         * @brief Defer execution to perform indirect addressing using the predecoded operand address.
+         */
+        void defer(const DecodedInstruction &decoded);
+
         /**
          * @brief Execute the instruction.
          */
@@ -163,13 +488,256 @@ namespace pdp8 {
 
         void execute_iot();
 
+        /**
+         * @brief Execute an operate instruction by testing the microinstruction bits in sequence.
+         * @details This is the reference implementation for the handlers in OprTable which
+         * execute() dispatches through.
+         */
         void execute_opr();
 
         bool readBinaryFormat(std::istream& iStream);
 
+        /**
+         * @brief Write the machine state to a snapshot.
+         * @details The snapshot holds core with its initialized and programmed bits, the registers and flags,
+         * the cycle state, the interrupt state, emulated time and the state of each attached device. Host
+         * settings such as the timing mode, profiler and terminals are not included.
+         * @throws SnapshotError if the stream fails.
+         */
+        void saveSnapshot(std::ostream &strm);
+
+        /**
+         * @brief Restore the machine state from a snapshot written by saveSnapshot().
+         * @details The same devices must be attached at the same device select codes as when the snapshot was
+         * taken. If restoring fails part way the machine should be reset or restored again.
+         * @throws SnapshotError if the snapshot is damaged or does not match this machine.
+         */
+        void restoreSnapshot(std::istream &strm);
+
+        /**
+         * @brief Create an independent copy of this machine which shares core copy on write.
+         * @details The fork has the same execution engine, timing mode, registers, flags and emulated time. Core
+         * pages are shared until either machine writes them, so a fork is cheap however large core is. Each
+         * attached device is replaced by its IOTDevice::clone(), attached at the same device select codes, with
+         * its state copied and its pending events scheduled again on the fork. Host connections such as
+         * terminals, the profiler and the lamp accumulator are not carried over, nor are predecoded
+         * instructions and cached blocks, which the fork rebuilds as it runs. The fork has the same sanitizer
+         * mode but none of the reports, and no breakpoints.
+         * @return The new machine.
+         * @throws std::logic_error if an attached device can not be cloned.
+         */
+        std::unique_ptr<PDP8> fork();
+
         void rimLoader();
 
         [[maybe_unused]] void reset();
+
+    protected:
+        /**
+         * @brief Fetch the next instruction through the predecode cache.
+         * @details Loads the instruction register and, for memory reference instructions, the operand address
+         * into the memory address register.
+         */
+        const DecodedInstruction &fetchDecoded();
+
+        Sanitizer sanitizer{};
+        bool sanitizerTrap{false};      ///< The sanitizer cleared the run flag.
+
+        Breakpoints breakpoints{};
+        bool breakpointsSet{false};     ///< A breakpoint or watchpoint is set, tested before each fetch.
+        bool memoryChecks{false};       ///< The sanitizer is on or a watchpoint is set, tested on each core access.
+        bool breakpointStop{false};     ///< A breakpoint cleared the run flag.
+        std::optional<fast_register_t> breakpointResume{};  ///< The execute breakpoint last stopped at.
+
+        void updateChecks() {
+            breakpointsSet = !breakpoints.empty();
+            memoryChecks = sanitizer.enabled() || breakpoints.watching();
+        }
+
+        /**
+         * @brief Check a read at the memory address for the sanitizer and read watchpoints.
+         */
+        void checkRead(Sanitizer::Access access) {
+            if (memoryChecks) [[unlikely]]
+                checkedRead(access);
+        }
+
+        /**
+         * @brief Check a write at the memory address for write watchpoints.
+         */
+        void checkWrite() {
+            if (memoryChecks) [[unlikely]]
+                watchAccess(Breakpoints::Access::Write);
+        }
+
+        void checkedRead(Sanitizer::Access access);
+
+        void watchAccess(Breakpoints::Access access);
+
+        void uninitializedAccess(Sanitizer::Access access);
+
+        /**
+         * @brief Called by the engines before each fetch.
+         * @return True if a breakpoint stopped execution, with the run flag clear.
+         */
+        bool breakpointBefore() {
+            if (breakpointsSet) [[unlikely]]
+                return checkBreakpoint();
+            return false;
+        }
+
+        bool checkBreakpoint();
+
+        void executeAnd() {
+            checkRead(Sanitizer::Access::Read);
+            accumulator.andOp(memory.read().getData());
+        }
+
+        void executeTad() {
+            checkRead(Sanitizer::Access::Read);
+            accumulator.addOp(memory.read().getData());
+        }
+
+        void executeIsz() {
+            checkRead(Sanitizer::Access::Read);
+            memory.read();
+            memory.memoryBuffer.setData(memory.memoryBuffer.getData() + 1);
+            memory.write();
+            checkWrite();
+            if (memory.memoryBuffer.getData() == 0)
+                ++memory.programCounter;
+        }
+
+        void executeDca() {
+            memory.memoryBuffer.setData(static_cast<unsigned short>(accumulator.getAcc()));
+            memory.write();
+            checkWrite();
+            accumulator.setAcc(0);
+        }
+
+        void executeJms() {
+            memory.memoryBuffer.setData(static_cast<unsigned short>(memory.programCounter.getProgramCounter()));
+            memory.write();
+            checkWrite();
+            memory.programCounter.setProgramCounter(memory.memoryAddress.getPageWordAddress() + 1);
+        }
+
+        /**
+         * @brief Execute JMP, detecting the idle loops JMP . and JMP .-1.
+         */
+        void executeJmp();
+
+        /**
+         * @brief Perform one machine cycle, the caller holds the lock.
+         */
+        void cycle();
+
+        /**
+         * @brief Poll for interrupts and, if the CPU is idle, the device it is waiting on.
+         * @return True if the CPU may fetch the next instruction.
+         * @throws std::runtime_error if the CPU is waiting on a device that is not connected.
+         */
+        bool interruptCheck();
+
+        /**
+         * @brief Execute up to maxInstructions whole instructions, the caller holds the lock.
+         */
+        RunExit runInstructions(unsigned long maxInstructions);
+
+        /**
+         * @brief The body of runInstructions() for ExecutionEngine::Threaded.
+         * @param count The number of instructions already executed in this batch.
+         * @param maxInstructions The instruction budget.
+         */
+        RunExit runThreaded(unsigned long count, unsigned long maxInstructions);
+
+        /**
+         * @brief The body of runInstructions() for ExecutionEngine::Block.
+         * @param count The number of instructions already executed in this batch.
+         * @param maxInstructions The instruction budget.
+         */
+        RunExit runBlocks(unsigned long count, unsigned long maxInstructions);
+
+        BlockCache blockCache{};
+
+        uint64_t instructionCount{0};       ///< Incremented by fetchDecoded().
+        uint64_t idleCycles{0};             ///< Emulated time skipped while idle.
+
+        TimingMode timingMode{TimingMode::FastAsPossible};
+        std::optional<EventScheduler::cycle_t> paceCycles{};    ///< The cycle count pacing started at.
+        std::chrono::steady_clock::time_point paceStart{};      ///< The host time pacing started at.
+
+        /**
+         * @brief The host time a cycle count is due in RealTime mode, starting pacing if necessary.
+         */
+        std::chrono::steady_clock::time_point paceTime(EventScheduler::cycle_t cycles);
+
+        /**
+         * @brief The body of idleAdvance(), the caller holds the lock.
+         */
+        std::chrono::steady_clock::duration advanceIdleTime();
+
+        /**
+         * @brief Run the engine selected for this PDP8, or the profiled switch engine while profiling.
+         */
+        RunExit runEngine(unsigned long count, unsigned long maxInstructions);
+
+        std::unique_ptr<Profiler> profiler{};
+
+        std::unique_ptr<LampAccumulator> lampAccumulator{};
+
+        std::unique_ptr<TraceBuffer> traceBuffer{};
+        std::filesystem::path traceDumpFile{};
+        std::unique_ptr<TraceStreamWriter> traceStream{};
+        bool tracing{false};                ///< True if either the trace buffer or the trace stream is enabled.
+        fast_register_t fetchLocation{0};   ///< The location of the last instruction fetched.
+
+        /**
+         * @brief Called by the engines as each instruction completes, to sample the lamps and trace it if enabled.
+         * @param deferred True if the instruction used a defer cycle.
+         */
+        void retire(bool deferred) {
+            if (lampAccumulator) [[unlikely]]
+                sampleLamps(deferred);
+            if (tracing) [[unlikely]]
+                traceInstruction();
+        }
+
+        void traceInstruction() {
+            TraceRecord record{static_cast<uint16_t>(fetchLocation), static_cast<uint16_t>(instructionReg.getWord()),
+                               static_cast<uint16_t>(memory.memoryAddress.value),
+                               static_cast<uint16_t>(accumulator.getArithmetic()),
+                               static_cast<uint16_t>(mulQuotient.getWord())};
+            if (traceBuffer)
+                traceBuffer->add(record);
+            if (traceStream)
+                traceStream->add(record);
+        }
+
+        /**
+         * @brief Write the trace to the dump file, if one was given to enableTrace().
+         * @details Failures are ignored, as this is called while the CPU is already stopping.
+         */
+        void writeTraceDump() const;
+
+        /**
+         * @brief Add the lamps shown at the end of an instruction to the accumulated duty cycles.
+         * @param deferred True if the instruction used a defer cycle.
+         */
+        void sampleLamps(bool deferred) {
+            lampAccumulator->add({memory.fieldRegister.getDataField(), memory.fieldRegister.getInstField(),
+                                  memory.programCounter.getProgramCounter(),
+                                  memory.memoryAddress.getPageWordAddress(), memory.memoryBuffer.getData(),
+                                  accumulator.getArithmetic(), stepCounter.value, mulQuotient.getWord(),
+                                  instructionReg.getOpCode(), deferred, interrupt_enable, run_flag});
+        }
+
+        /**
+         * @brief The body of runInstructions() for ExecutionEngine::Switch, and all engines while profiling.
+         * @tparam Profile The profiling policy, Profiler or NullProfiler.
+         */
+        template<class Profile>
+        RunExit runSwitch(unsigned long count, unsigned long maxInstructions, Profile &profile);
     };
 
 } // pdp8
@@ -0,0 +1,139 @@
+/*
+ * PanelRenderer.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file PanelRenderer.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "PanelRenderer.h"
+#include <Terminal.h>
+#include <array>
+#include <fmt/format.h>
+#include <iterator>
+
+namespace pdp8 {
+
+    namespace {
+        /**
+         * @brief The registers drawn as rows of lamps, most significant bit on the left.
+         */
+        struct PanelField {
+            uint16_t line;
+            uint16_t column;
+            unsigned width;
+        };
+
+        constexpr std::array<PanelField, 8> PanelFields{{
+            {3u, 2u, 3u},       // Data Field
+            {3u, 8u, 3u},       // Instruction Field
+            {3u, 14u, 12u},     // Program Counter
+            {6u, 14u, 12u},     // Memory Address
+            {9u, 14u, 12u},     // Memory Buffer
+            {12u, 12u, 13u},    // Link Accumulator
+            {15u, 2u, 5u},      // Step Counter
+            {15u, 14u, 12u},    // Multiplier Quotient
+        }};
+
+        /**
+         * @brief The single lamps: the eight op codes, the major states, then Ion, Pause and Run.
+         */
+        constexpr std::array<PanelRenderer::LampPosition, 14> PanelFlags{{
+            {2u, 44u}, {4u, 44u}, {6u, 44u}, {8u, 44u}, {10u, 44u}, {12u, 44u}, {14u, 44u}, {16u, 44u},
+            {2u, 56u}, {4u, 56u}, {6u, 56u},
+            {2u, 66u}, {4u, 66u}, {6u, 66u},
+        }};
+    }
+
+    namespace {
+        /**
+         * @brief The lamp glyph, followed by a space, for each brightness level using the SGR intensity attributes.
+         */
+        const std::array<std::string, PanelRenderer::Brightest + 1u> Glyph{
+                fmt::format("{} ", TerminalConsts::Light[0]),
+                fmt::format("\033[2m{}\033[22m ", TerminalConsts::Light[1]),
+                fmt::format("{} ", TerminalConsts::Light[1]),
+                fmt::format("\033[1m{}\033[22m ", TerminalConsts::Light[1])};
+    }
+
+    PanelRenderer::PanelRenderer(double refreshRate) {
+        setRefreshRate(refreshRate);
+        for (auto &field: PanelFields)
+            for (unsigned idx = 0; idx < field.width; ++idx)
+                layout.push_back({field.line, static_cast<uint16_t>(field.column + 2u * idx)});
+        layout.insert(layout.end(), PanelFlags.begin(), PanelFlags.end());
+        lamps.resize(layout.size());
+        invalidate();
+    }
+
+    void PanelRenderer::setRefreshRate(double refreshRate) {
+        framePeriod = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / refreshRate));
+    }
+
+    void PanelRenderer::invalidate() {
+        drawn.assign(layout.size(), Unknown);
+        statusDrawn = false;
+    }
+
+    void PanelRenderer::sample(const PanelSnapshot &panel) {
+        const std::array<fast_register_t, PanelFields.size()> values{
+                panel.dataField, panel.instField, panel.programCounter, panel.memoryAddress,
+                panel.memoryBuffer, panel.arithmetic, panel.stepCounter, panel.mulQuotient};
+
+        auto lamp = lamps.begin();
+        for (std::size_t field = 0; field < PanelFields.size(); ++field)
+            for (auto bit = PanelFields[field].width; bit > 0; --bit)
+                *lamp++ = static_cast<uint8_t>((values[field] >> (bit - 1u)) & 1u);
+
+        for (unsigned opCode = 0; opCode < 8u; ++opCode)
+            *lamp++ = panel.opCode == opCode;
+        *lamp++ = panel.cycleState == PDP8::CycleState::Fetch || panel.cycleState == PDP8::CycleState::Interrupt;
+        *lamp++ = panel.cycleState == PDP8::CycleState::Execute;
+        *lamp++ = panel.cycleState == PDP8::CycleState::Defer;
+        *lamp++ = panel.interruptEnable;
+        *lamp++ = false;
+        *lamp++ = panel.runFlag;
+
+        if (panel.hasIntensities) {
+            // Show the duty cycle as brightness, but a lamp lit at all is never drawn off.
+            for (std::size_t idx = 0; idx < lamps.size(); ++idx) {
+                auto intensity = panel.intensities[idx];
+                lamps[idx] = intensity == 0 ? 0u : static_cast<uint8_t>(1u + (intensity * (Brightest - 1u)) / 256u);
+            }
+        } else {
+            for (auto &level: lamps)
+                level = level ? Brightest : 0u;
+        }
+    }
+
+    const std::string &PanelRenderer::render(const PanelSnapshot &panel, std::string_view status, clock::time_point now) {
+        using namespace TerminalConsts;
+        lastFrame = now;
+        sample(panel);
+
+        frame = color(Regular, Yellow);
+        auto prefix = frame.size();
+        auto out = std::back_inserter(frame);
+        for (std::size_t idx = 0; idx < lamps.size(); ++idx) {
+            if (lamps[idx] != drawn[idx]) {
+                fmt::format_to(out, "\033[{};{}H{}", layout[idx].line, layout[idx].column, Glyph[lamps[idx]]);
+                drawn[idx] = lamps[idx];
+            }
+        }
+        if (!statusDrawn || status != drawnStatus) {
+            fmt::format_to(out, "\033[{};{}H{}", StatusPosition.line, StatusPosition.column, status);
+            drawnStatus = status;
+            statusDrawn = true;
+        }
+
+        if (frame.size() == prefix)
+            frame.clear();
+        else
+            frame.append(color(Regular));
+        return frame;
+    }
+
+} // pdp8
@@ -0,0 +1,115 @@
+/*
+ * PanelRenderer.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file PanelRenderer.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Draw the console front panel lamps as the difference from the last frame drawn.
+ * @details The renderer remembers the state of every lamp it has drawn and produces the escape sequences for only
+ * the lamps that changed, as one string per frame. Frames are limited to the refresh rate while the CPU runs.
+ * When the snapshot carries lamp duty cycles from the LampAccumulator each lamp is drawn at one of four brightness
+ * levels, otherwise lamps are drawn fully on or off.
+ */
+
+#ifndef PDP8_PANELRENDERER_H
+#define PDP8_PANELRENDERER_H
+
+#include <CpuRunner.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pdp8 {
+
+    /**
+     * @class PanelRenderer
+     */
+    class PanelRenderer {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        static constexpr double DefaultRefreshRate = 30.0;    ///< Frames per second.
+
+        static constexpr uint8_t Brightest = 3u;    ///< Lamps are drawn off, dim, normal or bright.
+
+        /**
+         * @brief The screen position of a lamp, the line and column start at 1.
+         */
+        struct LampPosition {
+            uint16_t line;
+            uint16_t column;
+        };
+
+        /**
+         * @brief The position of the status text which follows the OPR lamp.
+         */
+        static constexpr LampPosition StatusPosition{16u, 46u};
+
+    protected:
+        static constexpr uint8_t Unknown = 0xFFu;     ///< A lamp state that is never drawn, forcing a redraw.
+
+        clock::duration framePeriod{};
+        clock::time_point lastFrame{};
+
+        std::vector<LampPosition> layout{};
+        std::vector<uint8_t> lamps{};       ///< The lamp brightness levels to draw, in layout order.
+        std::vector<uint8_t> drawn{};       ///< The lamp states last drawn, in layout order.
+        std::string drawnStatus{};
+        bool statusDrawn{false};
+        std::string frame{};
+
+        /**
+         * @brief Fill lamps from a snapshot, in layout order.
+         */
+        void sample(const PanelSnapshot &panel);
+
+    public:
+        explicit PanelRenderer(double refreshRate = DefaultRefreshRate);
+
+        /**
+         * @brief Set the maximum number of frames per second drawn while the CPU runs.
+         */
+        void setRefreshRate(double refreshRate);
+
+        /**
+         * @brief True when a frame period has passed since the last frame was rendered.
+         */
+        [[nodiscard]] bool frameDue(clock::time_point now = clock::now()) const {
+            return now - lastFrame >= framePeriod;
+        }
+
+        /**
+         * @brief The time the next frame is due.
+         */
+        [[nodiscard]] clock::time_point nextFrame() const {
+            return lastFrame + framePeriod;
+        }
+
+        /**
+         * @brief Forget what has been drawn, the next frame redraws every lamp.
+         */
+        void invalidate();
+
+        /**
+         * @brief Render the lamps which differ from the last frame.
+         * @param panel The panel snapshot to draw.
+         * @param status The status text shown after the OPR lamp.
+         * @param now The frame time.
+         * @return The escape sequences and glyphs for the changed lamps, empty if nothing changed. The string is
+         * reused by the next call.
+         */
+        const std::string &render(const PanelSnapshot &panel, std::string_view status, clock::time_point now = clock::now());
+
+        [[nodiscard]] std::size_t lampCount() const {
+            return layout.size();
+        }
+    };
+
+} // pdp8
+
+#endif //PDP8_PANELRENDERER_H
@@ -6,12 +6,28 @@
  */
 
 #include <chrono>
-#include <thread>
+#include <fstream>
+#include <sstream>
 #include <assembler/NullStream.h>
+#include <DECWriter.h>
+#include <limits>
 #include "Pdp8Terminal.h"
 
 namespace pdp8 {
 
+    namespace {
+        /**
+         * @brief Parse a whole argument as an octal number no greater than limit.
+         */
+        std::optional<fast_register_t> parseOctal(const std::string &text, fast_register_t limit) {
+            char *end;
+            auto value = std::strtoul(text.c_str(), &end, 8);
+            if (text.empty() || *end != '\0' || value > limit)
+                return std::nullopt;
+            return static_cast<fast_register_t>(value);
+        }
+    }
+
     void Pdp8Terminal::initialize() {
         *oStrm << fmt::format("\033c"); oStrm->flush();
         *oStrm << fmt::format("\033[1;1H"); oStrm->flush();
@@ -19,10 +35,6 @@ namespace pdp8 {
         setCharacterMode();
         negotiateAboutWindowSize();
 
-        std::chrono::microseconds selectTimeout(10000);
-        std::this_thread::sleep_for(selectTimeout);
-
-        parseInput();
         commandHelp();
         inputBufferChanged();
         initialized = true;
@@ -34,9 +46,16 @@ namespace pdp8 {
 
         setCursorPosition();
 
-        if (pdp8.get_run_flag()) {
-            pdp8.instructionStep();
-            printPanel();
+        if (auto fault = cpuRunner.takeFault(); fault) {
+            commandHistory.push_back(fault.value());
+            printCommandHistory();
+        }
+
+        if (cpuRunner.getSnapshot().sequence != panelSequence) {
+            if (panelRenderer.frameDue())
+                printPanel();
+            else
+                tickDeadline = panelRenderer.nextFrame();
         }
     }
 
@@ -77,9 +96,58 @@ namespace pdp8 {
                 commandHistory.emplace_back("Load FORTH");
                 return;
             } else if (command == "RIM") {
-                pdp8.rimLoader();
+                cpuRunner.perform([](PDP8 &cpu) { cpu.rimLoader(); });
                 printPanel();
                 return;
+            } else if (command == "PROFILE") {
+                cpuRunner.perform([](PDP8 &cpu) { cpu.enableProfiler(); });
+                commandHistory.emplace_back("Profiling started");
+                return;
+            } else if (command == "PROFILE END") {
+                std::unique_ptr<Profiler> profile{};
+                cpuRunner.perform([&profile](PDP8 &cpu) { profile = cpu.disableProfiler(); });
+                if (profile) {
+                    std::ofstream reportFile{std::string{ProfileReportFile}};
+                    profile->report(reportFile);
+                    std::ofstream csvFile{std::string{ProfileCsvFile}};
+                    profile->writeCsv(csvFile);
+                    commandHistory.push_back(fmt::format("Profile written to {} and {}",
+                                                         ProfileReportFile, ProfileCsvFile));
+                } else {
+                    commandHistory.emplace_back("Profiling was not started");
+                }
+                return;
+            } else if (command == "TRACE") {
+                cpuRunner.perform([](PDP8 &cpu) {
+                    cpu.enableTrace(TraceBuffer::DefaultCapacity, std::string{TraceFile});
+                });
+                commandHistory.emplace_back("Tracing started");
+                return;
+            } else if (command == "TRACE DUMP") {
+                // The trace is dumped without stopping the CPU.
+                if (auto trace = pdp8.getTrace(); trace) {
+                    std::ofstream traceFile{std::string{TraceFile}, std::ios::binary};
+                    try {
+                        trace->dump(traceFile);
+                        commandHistory.push_back(fmt::format("Trace written to {}", TraceFile));
+                    } catch (const SnapshotError &e) {
+                        commandHistory.emplace_back(e.what());
+                    }
+                } else {
+                    commandHistory.emplace_back("Tracing was not started");
+                }
+                return;
+            } else if (command == "TRACE END") {
+                cpuRunner.perform([](PDP8 &cpu) { cpu.disableTrace(); });
+                commandHistory.emplace_back("Tracing stopped");
+                return;
+            } else if (auto verb = command.substr(0, command.find(' '));
+                    verb == "BREAK" || verb == "WATCH" || verb == "UNBREAK") {
+                breakpointCommand(command);
+                return;
+            } else if (command.starts_with("PRINT RATE")) {
+                printRateCommand(command);
+                return;
             } else if (command == "DECW") {
                 decWriter();
                 commandHistory.emplace_back("Load DECWriter");
@@ -91,8 +159,10 @@ namespace pdp8 {
                 case 'L': {
                     if (auto address = parseArgument(command.substr(1)); address) {
                         commandHistory.push_back(command);
-                        pdp8.memory.memoryAddress.setPageWordAddress(address.value());
-                        pdp8.memory.programCounter.setProgramCounter(address.value());
+                        cpuRunner.perform([address](PDP8 &cpu) {
+                            cpu.memory.memoryAddress.setPageWordAddress(address.value());
+                            cpu.memory.programCounter.setProgramCounter(address.value());
+                        });
                     }
                     printPanel();
                 }
@@ -101,50 +171,57 @@ namespace pdp8 {
                 case 'D': {
                     if (auto code = parseArgument(command.substr(1)); code) {
                         commandHistory.push_back(command);
-                        pdp8.memory.deposit(static_cast<Memory::base_type>(code.value()));
+                        cpuRunner.perform([code](PDP8 &cpu) {
+                            cpu.memory.deposit(static_cast<Memory::base_type>(code.value()));
+                        });
                     }
                     printPanel();
                 }
                     break;
                 case 'E': {
                     if (auto pc = parseArgument(command.substr(1)); pc) {
-                        auto word = pdp8.memory.read(static_cast<Memory::base_type>(pdp8.memory.fieldRegister.getInstField()),
-                                                     static_cast<Memory::base_type>(pc.value())).getData();
+                        Memory::base_type word{};
+                        cpuRunner.perform([pc, &word](PDP8 &cpu) {
+                            word = cpu.memory.read(static_cast<Memory::base_type>(cpu.memory.fieldRegister.getInstField()),
+                                                   static_cast<Memory::base_type>(pc.value())).getData();
+                        });
                         commandHistory.push_back(fmt::format("Examine {:04o} -> {:04o}", pc.value(), word));
                     }
                 }
                     break;
                 case 'e': {
-                    auto pc = pdp8.memory.programCounter.getProgramCounter();
-                    auto code = pdp8.memory.examine().getData();
+                    fast_register_t pc{};
+                    Memory::base_type code{};
+                    cpuRunner.perform([&pc, &code](PDP8 &cpu) {
+                        pc = cpu.memory.programCounter.getProgramCounter();
+                        code = cpu.memory.examine().getData();
+                    });
                     commandHistory.push_back(fmt::format("Examine {:04o} -> {:04o}", pc, code));
                 }
                     printPanel();
                     lastCommand = command;
                     break;
                 case 'c':
-                    pdp8.set_step_flag(true);
-                    commandHistory.push_back(fmt::format("1 Cycle @ {:04o}", pdp8.memory.programCounter.getProgramCounter()));
-                    while (pdp8.get_step_flag()) {
-                        pdp8.instructionStep();
-                        printPanel();
-                    }
+                    commandHistory.push_back(fmt::format("1 Cycle @ {:04o}", cpuRunner.getSnapshot().programCounter));
+                    cpuRunner.perform([](PDP8 &cpu) {
+                        cpu.set_step_flag(true);
+                        while (cpu.get_step_flag())
+                            cpu.instructionStep();
+                    });
+                    printPanel();
                     lastCommand = command;
                     break;
                 case 's':
-                    pdp8.set_instruction_flag(true);
-                    commandHistory.push_back(fmt::format("1 Instruction @ {:04o}", pdp8.memory.programCounter.getProgramCounter()));
-                    while (pdp8.get_instruction_flag()) {
-                        pdp8.instructionStep();
-                        printPanel();
-                    }
+                    commandHistory.push_back(fmt::format("1 Instruction @ {:04o}", cpuRunner.getSnapshot().programCounter));
+                    cpuRunner.perform([](PDP8 &cpu) { cpu.step(); });
+                    printPanel();
                     lastCommand = command;
                     break;
                 case 'C':
-                    pdp8.set_run_flag(true);
+                    cpuRunner.post([](PDP8 &cpu) { cpu.set_run_flag(true); });
                     break;
                 case 'S':
-                    pdp8.set_run_flag(false);
+                    cpuRunner.perform([](PDP8 &cpu) { cpu.set_run_flag(false); });
                     printPanel();
                     break;
                 case '?':
@@ -159,42 +236,13 @@ namespace pdp8 {
     }
 
     void Pdp8Terminal::printPanel() {
-        using namespace TerminalConsts;
-        *oStrm << fmt::format("{}", color(Regular, Yellow));
-
-        size_t line = 3, column = 2;
-        std::tie(line, column) = printPanelField(line, column, 3, static_cast<uint>(pdp8.memory.fieldRegister.getDataField()));
-        std::tie(line, column) = printPanelField(line, column, 3, static_cast<uint>(pdp8.memory.fieldRegister.getInstField()));
-        std::tie(line, column) = printPanelField(line, column, 12, static_cast<uint>(pdp8.memory.programCounter.getProgramCounter()));
-        std::tie(line, column) = printPanelField(line + 3u, 14u, 12, static_cast<uint>(pdp8.memory.memoryAddress.getPageWordAddress()));
-        std::tie(line, column) = printPanelField(line + 3u, 14u, 12, static_cast<uint>(pdp8.memory.memoryBuffer.getData()));
-        std::tie(line, column) = printPanelField(line + 3u, 12u, 13, static_cast<uint>(pdp8.accumulator.getArithmetic()));
-        std::tie(line, column) = printPanelField(line + 3u, 2u, 5, static_cast<uint>(pdp8.stepCounter.value));
-        std::tie(line, column) = printPanelField(line, 14u, 12, static_cast<uint>(pdp8.mulQuotient.getWord()));
-
-        printPanelFlag(2u, 44u, static_cast<OpCode>(pdp8.instructionReg.getOpCode()) == OpCode::AND);
-        printPanelFlag(4u, 44u, static_cast<OpCode>(pdp8.instructionReg.getOpCode()) == OpCode::TAD);
-        printPanelFlag(6u, 44u, static_cast<OpCode>(pdp8.instructionReg.getOpCode()) == OpCode::ISZ);
-        printPanelFlag(8u, 44u, static_cast<OpCode>(pdp8.instructionReg.getOpCode()) == OpCode::DCA);
-        printPanelFlag(10u, 44u, static_cast<OpCode>(pdp8.instructionReg.getOpCode()) == OpCode::JMS);
-        printPanelFlag(12u, 44u, static_cast<OpCode>(pdp8.instructionReg.getOpCode()) == OpCode::JMP);
-        printPanelFlag(14u, 44u, static_cast<OpCode>(pdp8.instructionReg.getOpCode()) == OpCode::IOT);
-        printPanelFlag(16u, 44u, static_cast<OpCode>(pdp8.instructionReg.getOpCode()) == OpCode::OPR);
-        *oStrm << fmt::format("  Managed terms: {:02}", pdp8.terminalManager.size());
-
-        printPanelFlag(2u, 56u, pdp8.cycle_state == PDP8::CycleState::Fetch ||
-                                pdp8.cycle_state == PDP8::CycleState::Interrupt);
-        printPanelFlag(4u, 56u, pdp8.cycle_state == PDP8::CycleState::Execute);
-        printPanelFlag(6u, 56u, pdp8.cycle_state == PDP8::CycleState::Defer);
-
-        printPanelFlag(2u, 66u, pdp8.interrupt_enable);
-        printPanelFlag(4u, 66u, false);
-        printPanelFlag(6u, 66u, pdp8.get_run_flag());
-
-        *oStrm << fmt::format("{}", color(Regular));
-        setCursorPosition();
-
-        out().flush();
+        auto panel = cpuRunner.takeFrame();
+        panelSequence = panel.sequence;
+        auto &frame = panelRenderer.render(panel, fmt::format("  Managed terms: {:02}", pdp8.terminalManager.size()));
+        if (!frame.empty()) {
+            *oStrm << frame << fmt::format("\033[{};{}H", inputLine, inputColumn);
+            out().flush();
+        }
     }
 
     void Pdp8Terminal::printPanelSilk() {
@@ -241,7 +289,7 @@ namespace pdp8 {
         std::stringstream binary;
 
         auto terminal = std::make_shared<TelnetTerminal>();
-        pdp8.terminalManager.terminalQueue = terminal;
+        pdp8.terminalManager.queueTerminal(terminal);
 
         terminal->out() << fmt::format("\033c");
         terminal->out() << fmt::format("\033[1;1H");
@@ -252,7 +300,7 @@ namespace pdp8 {
 
         assembler.dumpSymbols(terminal->out());
         terminal->out().flush();
-        pdp8.readBinaryFormat(binary);
+        cpuRunner.perform([&binary](PDP8 &cpu) { cpu.readBinaryFormat(binary); });
         printPanel();
     }
 
@@ -310,7 +358,7 @@ namespace pdp8 {
             auto code = std::strtoul(argument.c_str(), &pos, 8);
             if (static_cast<size_t>(pos - argument.c_str()) == argument.length())
                 return code;
-            return pdp8asm::generateOpCode(argument, static_cast<unsigned int>(pdp8.memory.programCounter.getProgramCounter()));
+            return pdp8asm::generateOpCode(argument, static_cast<unsigned int>(cpuRunner.getSnapshot().programCounter));
         } catch (const std::invalid_argument &ia) {
             commandHistory.emplace_back(ia.what());
         } catch (const std::out_of_range &oor) {
@@ -318,4 +366,121 @@ namespace pdp8 {
         }
         return std::nullopt;
     }
+
+    std::optional<fast_register_t> Pdp8Terminal::parseLocation(const std::string &location) {
+        fast_register_t field{0};
+        auto address = location;
+        if (auto colon = location.find(':'); colon != std::string::npos) {
+            auto parsed = parseOctal(location.substr(0, colon), 7);
+            if (!parsed) {
+                commandHistory.push_back(fmt::format("Error: bad field in {}", location));
+                return std::nullopt;
+            }
+            field = parsed.value();
+            address = location.substr(colon + 1);
+        }
+
+        if (auto symbol = assembler.symbolTable.find(address);
+                symbol != assembler.symbolTable.end() && symbol->second.status == pdp8asm::Defined)
+            return (field << 12u) | (symbol->second.value & 07777u);
+        if (auto parsed = parseOctal(address, 07777); parsed)
+            return (field << 12u) | parsed.value();
+        commandHistory.push_back(fmt::format("Error: {} is not an address or a label", address));
+        return std::nullopt;
+    }
+
+    void Pdp8Terminal::breakpointCommand(const std::string &command) {
+        std::vector<std::string> words{};
+        std::istringstream stream{command};
+        for (std::string word; stream >> word;)
+            words.push_back(word);
+
+        if (words.front() == "UNBREAK") {
+            if (words.size() == 1) {
+                cpuRunner.perform([](PDP8 &cpu) { cpu.clearBreakpoints(); });
+                commandHistory.emplace_back("Breakpoints cleared");
+            } else if (auto location = parseLocation(words[1]); location) {
+                bool cleared{false};
+                cpuRunner.perform([&cleared, location](PDP8 &cpu) { cleared = cpu.clearBreakpoint(location.value()); });
+                commandHistory.push_back(fmt::format("{} at {}", cleared ? "Breakpoints cleared" : "No breakpoints",
+                                                     words[1]));
+            }
+            return;
+        }
+
+        if (words.size() == 1 && words.front() == "BREAK") {
+            std::vector<std::string> list{};
+            cpuRunner.perform([&list](PDP8 &cpu) {
+                for (auto &breakpoint: cpu.getBreakpoints().getBreakpoints())
+                    list.push_back(Breakpoints::format(breakpoint));
+            });
+            if (list.empty())
+                commandHistory.emplace_back("No breakpoints");
+            commandHistory.insert(commandHistory.end(), list.begin(), list.end());
+            return;
+        }
+
+        // BREAK <loc> [AC <octal>] or WATCH READ|WRITE <loc> [AC <octal>]
+        Breakpoints::Breakpoint breakpoint{};
+        std::size_t next{1};
+        if (words.front() == "WATCH") {
+            if (words.size() > 1 && words[1] == "READ")
+                breakpoint.access = Breakpoints::Access::Read;
+            else if (words.size() > 1 && words[1] == "WRITE")
+                breakpoint.access = Breakpoints::Access::Write;
+            else {
+                commandHistory.emplace_back("Error: WATCH READ or WATCH WRITE");
+                return;
+            }
+            next = 2;
+        }
+        if (words.size() != next + 1 && (words.size() != next + 3 || words[next + 1] != "AC")) {
+            commandHistory.push_back(fmt::format("Error: {} <loc> [AC <octal>]", words.front()));
+            return;
+        }
+
+        auto location = parseLocation(words[next]);
+        if (!location)
+            return;
+        breakpoint.location = location.value();
+        if (words.size() == next + 3) {
+            breakpoint.arithmetic = parseOctal(words[next + 2], 07777);
+            if (!breakpoint.arithmetic) {
+                commandHistory.push_back(fmt::format("Error: bad AC value {}", words[next + 2]));
+                return;
+            }
+        }
+
+        cpuRunner.perform([breakpoint](PDP8 &cpu) { cpu.setBreakpoint(breakpoint); });
+        commandHistory.push_back(fmt::format("Set {}", Breakpoints::format(breakpoint)));
+    }
+
+    void Pdp8Terminal::printRateCommand(const std::string &command) {
+        std::optional<unsigned int> rate{};
+        if (auto argument = command.substr(std::string_view{"PRINT RATE"}.size()); !argument.empty()) {
+            char *end;
+            auto value = std::strtoul(argument.c_str(), &end, 10);
+            if (*end != '\0' || value > std::numeric_limits<unsigned int>::max()) {
+                commandHistory.emplace_back("Error: PRINT RATE [<characters per second>]");
+                return;
+            }
+            rate = static_cast<unsigned int>(value);
+        }
+
+        std::optional<unsigned int> current{};
+        cpuRunner.perform([rate, &current](PDP8 &cpu) {
+            for (auto &[deviceSel, device]: cpu.iotDevices)
+                if (auto decWriter = std::dynamic_pointer_cast<DECWriter>(device); decWriter) {
+                    if (rate)
+                        decWriter->setPrintRate(rate.value());
+                    current = decWriter->getPrintRate();
+                }
+        });
+        if (!current)
+            commandHistory.emplace_back("No DECWriter attached");
+        else if (current.value() == 0)
+            commandHistory.emplace_back("DECWriter prints without a rate limit");
+        else
+            commandHistory.push_back(fmt::format("DECWriter prints {} characters per second", current.value()));
+    }
 }
@@ -9,6 +9,8 @@
 
 #include "Terminal.h"
 #include "PDP8.h"
+#include "CpuRunner.h"
+#include "PanelRenderer.h"
 #include "assembler/Assembler.h"
 #include "assembler/TestPrograms.h"
 #include <fmt/format.h>
@@ -26,10 +28,16 @@ namespace pdp8 {
 
         pdp8asm::Assembler assembler{};
 
+        CpuRunner cpuRunner;
+
     protected:
 
         std::string lastCommand{};
 
+        unsigned long panelSequence{0};         ///< The sequence number of the last snapshot drawn.
+
+        PanelRenderer panelRenderer{};
+
         bool initialized{false};
         bool runConsole{true};
 
@@ -43,6 +51,7 @@ namespace pdp8 {
             TelnetTerminal::windowSizeChanged();
             inputLine = termHeight;
             *oStrm << fmt::format("\033[2J");
+            panelRenderer.invalidate();
             printPanelSilk();
             printPanel();
             inputBufferChanged();
@@ -58,37 +67,48 @@ namespace pdp8 {
 
         std::optional<unsigned int> parseArgument(const std::string &argument);
 
-        static constexpr std::array<std::string_view, 6> CommandLineHelp =
+        /**
+         * @brief Parse a location as [field:]address, the address in octal or a label of the program loaded.
+         * @return The 15 bit location, or nothing after reporting the error.
+         */
+        std::optional<fast_register_t> parseLocation(const std::string &location);
+
+        /**
+         * @brief Perform a BREAK, WATCH or UNBREAK command.
+         */
+        void breakpointCommand(const std::string &command);
+
+        /**
+         * @brief Perform a PRINT RATE command, showing or setting the DECWriter print rate.
+         */
+        void printRateCommand(const std::string &command);
+
+        static constexpr std::string_view ProfileReportFile = "pdp8-profile.txt";
+        static constexpr std::string_view ProfileCsvFile = "pdp8-profile.csv";
+        static constexpr std::string_view TraceFile = "pdp8-trace.bin";
+
+        static constexpr std::array<std::string_view, 13> CommandLineHelp =
                 {{
                          "l <octal> -- Load Address.            d <octal> -- Deposit at address.",
                          "e -- Examine at address, repeats.     c -- CPU single cycle, repeats.",
                          "s -- CPU single instruction, repeats. ?|h -- Print this help.",
                          "C -- Continue from current address.   S -- Stop execution.",
                          "PING PONG -- Assemble and load built in program.",
+                         "PROFILE -- Start profiling.           PROFILE END -- Write the profile.",
+                         "TRACE -- Start tracing, dump on HLT.  TRACE DUMP -- Write the trace now.",
+                         "TRACE END -- Stop tracing.",
+                         "BREAK <loc> [AC <octal>] -- Stop at loc.  BREAK -- List breakpoints.",
+                         "WATCH READ|WRITE <loc> [AC <octal>] -- Stop after loc is read or written.",
+                         "UNBREAK [<loc>] -- Clear breakpoints. <loc> is [field:]octal or a label.",
+                         "PRINT RATE [<cps>] -- Show or set the DECWriter print rate, 0 for no limit.",
                          "quit -- Exit the program."
                  }};
 
-        std::tuple<size_t, size_t> printPanelField(size_t line, size_t col, size_t width, uint value) {
-            using namespace TerminalConsts;
-            for (auto idx = width; idx > 0; --idx) {
-                setCursorPosition(line, col);
-                auto lightIdx = value & (1 << (idx - 1)) ? 1 : 0;
-                *oStrm << fmt::format("{} ", Light[lightIdx]);
-                col += 2;
-            }
-            return {line, col};
-        }
-
-        template<typename U1, typename U2>
-        requires std::unsigned_integral<U1> && std::unsigned_integral<U2>
-        void printPanelFlag(U1 line, U2 col, bool flag) {
-            using namespace TerminalConsts;
-            setCursorPosition(line, col);
-            *oStrm << fmt::format("{} ", Light[flag ? 1 : 0]);
-        }
-
         void printPanelSilk();
 
+        /**
+         * @brief Draw the lamps that changed since the last frame from the latest snapshot.
+         */
         void printPanel();
 
         void loadPingPong();
@@ -108,7 +128,8 @@ namespace pdp8 {
 
         ~Pdp8Terminal() override = default;
 
-        explicit Pdp8Terminal(PDP8& pdp8) : TelnetTerminal(), pdp8(pdp8) {
+        explicit Pdp8Terminal(PDP8& pdp8) : TelnetTerminal(), pdp8(pdp8), cpuRunner(pdp8) {
+            cpuRunner.post([](PDP8 &cpu) { cpu.enableLampAccumulator(true); });
             timerTick = [this]() -> bool {
                 console();
                 return runConsole;
@@ -117,6 +138,13 @@ namespace pdp8 {
 
         void console();
 
+        /**
+         * @brief Set the maximum panel frames per second while the CPU runs.
+         */
+        void setPanelRefreshRate(double refreshRate) {
+            panelRenderer.setRefreshRate(refreshRate);
+        }
+
         int selected(bool selectedRead, bool selectedWrite) override;
     };
 }
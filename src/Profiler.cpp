@@ -0,0 +1,92 @@
+/*
+ * Profiler.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Profiler.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "Profiler.h"
+#include "Instruction.h"
+#include <algorithm>
+#include <fmt/format.h>
+#include <utility>
+
+namespace pdp8 {
+
+    namespace {
+        /**
+         * @brief The non-zero entries of a histogram as (index, count) sorted by decreasing count.
+         */
+        template<class Counts>
+        std::vector<std::pair<std::size_t, Profiler::counter_t>> sorted(const Counts &counts) {
+            std::vector<std::pair<std::size_t, Profiler::counter_t>> entries{};
+            for (std::size_t idx = 0; idx < counts.size(); ++idx)
+                if (counts[idx])
+                    entries.emplace_back(idx, counts[idx]);
+            std::ranges::stable_sort(entries, [](auto &a, auto &b) { return a.second > b.second; });
+            return entries;
+        }
+
+        double percent(Profiler::counter_t count, Profiler::counter_t total) {
+            return total ? 100.0 * static_cast<double>(count) / static_cast<double>(total) : 0.0;
+        }
+    }
+
+    void Profiler::clear() {
+        std::ranges::fill(locations, 0u);
+        opCodes.fill(0u);
+        operates.fill(0u);
+        iots.fill(0u);
+        indirects = autoIndexes = instructions = 0u;
+    }
+
+    void Profiler::report(std::ostream &strm, std::size_t maxLocations) const {
+        strm << fmt::format("Instructions: {}\n", instructions);
+
+        strm << "\nLocations\n";
+        auto hot = sorted(locations);
+        if (hot.size() > maxLocations)
+            hot.resize(maxLocations);
+        for (auto &[location, count]: hot)
+            strm << fmt::format("  {:o} {:04o} {:>12} {:6.2f}%\n", location >> 12u, location & 07777u,
+                                count, percent(count, instructions));
+
+        strm << "\nOp Codes\n";
+        for (auto &[opCode, count]: sorted(opCodes))
+            strm << fmt::format("  {} {:>12} {:6.2f}%\n", OpCodeStr[opCode], count, percent(count, instructions));
+
+        strm << "\nOperate Microinstructions\n";
+        for (auto &[bits, count]: sorted(operates))
+            strm << fmt::format("  {:04o} {:>12} {:6.2f}%\n", 07000u | bits, count, percent(count, instructions));
+
+        strm << fmt::format("\nDefer cycles: {} of which auto index: {}\n", indirects, autoIndexes);
+
+        strm << "\nIOT by Device\n";
+        for (auto &[deviceSel, count]: sorted(iots))
+            strm << fmt::format("  {:02o} {:>12}\n", deviceSel, count);
+    }
+
+    void Profiler::writeCsv(std::ostream &strm) const {
+        strm << "section,key,count\n";
+        strm << fmt::format("total,instructions,{}\n", instructions);
+        for (std::size_t location = 0; location < locations.size(); ++location)
+            if (locations[location])
+                strm << fmt::format("location,{:o}{:04o},{}\n", location >> 12u, location & 07777u, locations[location]);
+        for (std::size_t opCode = 0; opCode < opCodes.size(); ++opCode)
+            if (opCodes[opCode])
+                strm << fmt::format("opcode,{},{}\n", OpCodeStr[opCode], opCodes[opCode]);
+        for (std::size_t bits = 0; bits < operates.size(); ++bits)
+            if (operates[bits])
+                strm << fmt::format("operate,{:04o},{}\n", 07000u | bits, operates[bits]);
+        strm << fmt::format("defer,indirect,{}\n", indirects);
+        strm << fmt::format("defer,autoindex,{}\n", autoIndexes);
+        for (std::size_t deviceSel = 0; deviceSel < iots.size(); ++deviceSel)
+            if (iots[deviceSel])
+                strm << fmt::format("iot,{:02o},{}\n", deviceSel, iots[deviceSel]);
+    }
+
+} // pdp8
@@ -0,0 +1,123 @@
+/*
+ * Profiler.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Profiler.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Instruction level profiling of emulated programs.
+ * @details The switch engine loop is a template on a profiling policy. Without a Profiler it is instantiated
+ * with NullProfiler whose hooks are empty, so the normal loop carries no profiling code at all.
+ */
+
+#ifndef PDP8_PROFILER_H
+#define PDP8_PROFILER_H
+
+#include <HostInterface.h>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace pdp8 {
+
+    /**
+     * @struct NullProfiler
+     * @brief The profiling policy used when profiling is off.
+     */
+    struct NullProfiler {
+        static constexpr bool Enabled = false;
+
+        void instruction(std::size_t, small_register_t) {}
+
+        void indirect(bool) {}
+
+        void iot(small_register_t) {}
+    };
+
+    /**
+     * @class Profiler
+     * @brief Execution counts gathered while PDP8::enableProfiler() is in effect.
+     */
+    class Profiler {
+    public:
+        static constexpr bool Enabled = true;
+
+        using counter_t = uint64_t;
+
+    protected:
+        std::vector<counter_t> locations = std::vector<counter_t>(NumberOfFields * 4096);
+        std::array<counter_t, 8> opCodes{};
+        std::array<counter_t, 512> operates{};
+        std::array<counter_t, 64> iots{};
+        counter_t indirects{0};
+        counter_t autoIndexes{0};
+        counter_t instructions{0};
+
+    public:
+        /**
+         * @brief Count an instruction.
+         * @param location The 15 bit field and address the instruction was fetched from.
+         * @param word The instruction.
+         */
+        void instruction(std::size_t location, small_register_t word) {
+            ++instructions;
+            ++locations[location];
+            ++opCodes[(word >> 9u) & 07u];
+            if ((word & 07000u) == 07000u)
+                ++operates[word & 0777u];
+        }
+
+        /**
+         * @brief Count a defer cycle.
+         * @param autoIndex True if the pointer was an auto index register, 010 to 017 on page 0.
+         */
+        void indirect(bool autoIndex) {
+            ++indirects;
+            if (autoIndex)
+                ++autoIndexes;
+        }
+
+        /**
+         * @brief Count an IOT to a device.
+         * @param deviceSel The six bit device select code.
+         */
+        void iot(small_register_t deviceSel) {
+            ++iots[deviceSel & 077u];
+        }
+
+        void clear();
+
+        [[nodiscard]] counter_t getInstructions() const { return instructions; }
+
+        [[nodiscard]] counter_t getCount(std::size_t location) const { return locations.at(location); }
+
+        [[nodiscard]] counter_t getOpCodeCount(unsigned opCode) const { return opCodes.at(opCode); }
+
+        [[nodiscard]] counter_t getOperateCount(unsigned bits) const { return operates.at(bits); }
+
+        [[nodiscard]] counter_t getIotCount(unsigned deviceSel) const { return iots.at(deviceSel); }
+
+        [[nodiscard]] counter_t getIndirects() const { return indirects; }
+
+        [[nodiscard]] counter_t getAutoIndexes() const { return autoIndexes; }
+
+        /**
+         * @brief Write a human readable report with each histogram sorted by count.
+         * @param strm The output stream.
+         * @param maxLocations The number of most executed locations to list.
+         */
+        void report(std::ostream &strm, std::size_t maxLocations = 32) const;
+
+        /**
+         * @brief Write every non-zero count as CSV lines of section,key,count.
+         * @param strm The output stream.
+         */
+        void writeCsv(std::ostream &strm) const;
+    };
+
+} // pdp8
+
+#endif //PDP8_PROFILER_H
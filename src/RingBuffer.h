@@ -0,0 +1,87 @@
+/*
+ * RingBuffer.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file RingBuffer.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief A lock free single producer, single consumer ring buffer.
+ * @details Used to pass device output from the CPU execution thread to the terminal service thread. One thread
+ * may push while another pops, the consumer takes everything available in one call so it can be written to the
+ * terminal as a single write.
+ */
+
+#ifndef PDP8_RINGBUFFER_H
+#define PDP8_RINGBUFFER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+namespace pdp8 {
+
+    /**
+     * @class RingBuffer
+     * @tparam T The element type.
+     * @tparam Capacity The number of elements held, a power of two.
+     */
+    template<class T, std::size_t Capacity>
+    requires (Capacity > 0 && (Capacity & (Capacity - 1)) == 0)
+    class RingBuffer {
+    protected:
+        static constexpr std::size_t Mask = Capacity - 1;
+
+        std::array<T, Capacity> elements{};
+        alignas(64) std::atomic<std::size_t> head{0};      ///< The next element to pop, written by the consumer.
+        alignas(64) std::atomic<std::size_t> tail{0};      ///< The next element to push, written by the producer.
+
+    public:
+        /**
+         * @brief Add an element, called by the producer.
+         * @return False if the buffer is full.
+         */
+        bool push(const T &element) {
+            auto position = tail.load(std::memory_order_relaxed);
+            if (position - head.load(std::memory_order_acquire) == Capacity)
+                return false;
+            elements[position & Mask] = element;
+            tail.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Remove up to destination.size() elements, called by the consumer.
+         * @return The number of elements removed.
+         */
+        std::size_t pop(std::span<T> destination) {
+            auto position = head.load(std::memory_order_relaxed);
+            auto count = std::min(destination.size(), tail.load(std::memory_order_acquire) - position);
+            for (std::size_t idx = 0; idx < count; ++idx)
+                destination[idx] = elements[(position + idx) & Mask];
+            head.store(position + count, std::memory_order_release);
+            return count;
+        }
+
+        /**
+         * @brief The number of elements held, the other thread may change it as soon as it is read.
+         */
+        [[nodiscard]] std::size_t size() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] bool empty() const {
+            return size() == 0;
+        }
+
+        static constexpr std::size_t capacity() {
+            return Capacity;
+        }
+    };
+
+} // pdp8
+
+#endif //PDP8_RINGBUFFER_H
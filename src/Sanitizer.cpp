@@ -0,0 +1,43 @@
+/*
+ * Sanitizer.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Sanitizer.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "Sanitizer.h"
+#include <fmt/format.h>
+
+namespace pdp8 {
+
+    void Sanitizer::setMode(Mode newMode) {
+        mode = newMode;
+        reported.clear();
+        reports.clear();
+        accessCount = 0;
+        lastAccess.reset();
+    }
+
+    bool Sanitizer::record(Access access, fast_register_t location, fast_register_t programCounter) {
+        ++accessCount;
+        lastAccess = Report{access, location, programCounter};
+        if (!reported.test(location)) {
+            reported.set(location);
+            if (reports.size() < MaxReports)
+                reports.push_back(lastAccess.value());
+        }
+        return mode == Mode::Trap;
+    }
+
+    std::string Sanitizer::format(const Report &report) {
+        return fmt::format("{} of {:o}:{:04o} uninitialized at PC {:o}:{:04o}",
+                           report.access == Access::Execute ? "Execute" : "Read",
+                           report.location >> 12u, report.location & 07777u,
+                           report.programCounter >> 12u, report.programCounter & 07777u);
+    }
+
+} // pdp8
@@ -0,0 +1,106 @@
+/*
+ * Sanitizer.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Sanitizer.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Detection of reads of core that has never been written.
+ * @details When enabled the CPU tests the Memory initialized bitmap on each instruction fetch, each operand read
+ * by AND, TAD and ISZ, and each indirect address read by a defer cycle. Each location found uninitialized is
+ * reported once, with the location of the instruction that read it. A test is one bit in a packed bitmap, and
+ * when the sanitizer is off the CPU only tests a flag, so it can be left on for regression runs.
+ */
+
+#ifndef PDP8_SANITIZER_H
+#define PDP8_SANITIZER_H
+
+#include <HostInterface.h>
+#include <Memory.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pdp8 {
+
+    /**
+     * @class Sanitizer
+     */
+    class Sanitizer {
+    public:
+        enum class Mode {
+            Off,        ///< Core reads are not checked.
+            Log,        ///< Uninitialized reads are reported and execution continues.
+            Trap,       ///< Uninitialized reads are reported and the CPU stops after the instruction.
+        };
+
+        enum class Access {
+            Execute,    ///< An instruction was fetched from the location.
+            Read,       ///< An operand or indirect address was read from the location.
+        };
+
+        /**
+         * @brief An uninitialized read. Locations are 15 bit field and address.
+         */
+        struct Report {
+            Access access;
+            fast_register_t location;           ///< The location read.
+            fast_register_t programCounter;     ///< The location of the instruction that read it.
+        };
+
+        static constexpr std::size_t MaxReports = 1024;     ///< Reports kept, later ones are only counted.
+
+    protected:
+        Mode mode{Mode::Off};
+        CoreBitmap reported{};              ///< Locations already reported.
+        std::vector<Report> reports{};
+        uint64_t accessCount{0};            ///< Every uninitialized read, including repeats.
+        std::optional<Report> lastAccess{};
+
+    public:
+        /**
+         * @brief Change the mode and discard the reports gathered so far.
+         */
+        void setMode(Mode newMode);
+
+        [[nodiscard]] Mode getMode() const {
+            return mode;
+        }
+
+        [[nodiscard]] bool enabled() const {
+            return mode != Mode::Off;
+        }
+
+        /**
+         * @brief Record an uninitialized read.
+         * @return True if execution should stop.
+         */
+        bool record(Access access, fast_register_t location, fast_register_t programCounter);
+
+        [[nodiscard]] const std::vector<Report> &getReports() const {
+            return reports;
+        }
+
+        [[nodiscard]] uint64_t getAccessCount() const {
+            return accessCount;
+        }
+
+        /**
+         * @brief The most recent uninitialized read, in Trap mode the one that stopped the CPU.
+         */
+        [[nodiscard]] const std::optional<Report> &getLastAccess() const {
+            return lastAccess;
+        }
+
+        /**
+         * @brief Describe a report, for example "Read of 0:1234 uninitialized at PC 0:0200".
+         */
+        static std::string format(const Report &report);
+    };
+
+} // pdp8
+
+#endif //PDP8_SANITIZER_H
@@ -0,0 +1,50 @@
+/*
+ * Snapshot.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Snapshot.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "Snapshot.h"
+#include <array>
+
+namespace pdp8 {
+
+    void SnapshotWriter::write(uint64_t value, unsigned int bytes) {
+        std::array<char, 8> buffer{};
+        for (unsigned int idx = 0; idx < bytes; ++idx, value >>= 8u)
+            buffer[idx] = static_cast<char>(value & 0xFFu);
+        strm.write(buffer.data(), bytes);
+    }
+
+    void SnapshotWriter::writeBlock(std::string_view block) {
+        writeCount(block.size());
+        strm.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+
+    uint64_t SnapshotReader::read(unsigned int bytes) {
+        std::array<char, 8> buffer{};
+        if (!strm.read(buffer.data(), bytes))
+            throw SnapshotError("Snapshot is truncated.");
+        uint64_t value{0};
+        for (unsigned int idx = bytes; idx > 0; --idx)
+            value = (value << 8u) | static_cast<unsigned char>(buffer[idx - 1]);
+        return value;
+    }
+
+    std::string SnapshotReader::readBlock() {
+        auto length = readCount();
+        if (length > MaxBlock)
+            throw SnapshotError("Snapshot block is too large.");
+        std::string block{};
+        block.resize(length);
+        if (!strm.read(block.data(), static_cast<std::streamsize>(length)))
+            throw SnapshotError("Snapshot is truncated.");
+        return block;
+    }
+
+} // pdp8
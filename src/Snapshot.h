@@ -0,0 +1,112 @@
+/*
+ * Snapshot.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Snapshot.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Binary machine state snapshots.
+ * @details A snapshot is written by PDP8::saveSnapshot() and read back by PDP8::restoreSnapshot(). Values are
+ * stored little endian in fixed widths so a snapshot may be moved between hosts. Each device writes its state
+ * through IOTDevice::serialize() into its own length prefixed block.
+ */
+
+#ifndef PDP8_SNAPSHOT_H
+#define PDP8_SNAPSHOT_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace pdp8 {
+
+    /**
+     * @class SnapshotError
+     * @brief Thrown when a snapshot can not be read or does not match the machine it is restored to.
+     */
+    class SnapshotError : public std::runtime_error {
+    public:
+        explicit SnapshotError(const std::string &what) : std::runtime_error(what) {}
+    };
+
+    /**
+     * @class SnapshotWriter
+     */
+    class SnapshotWriter {
+    protected:
+        std::ostream &strm;
+
+        void write(uint64_t value, unsigned int bytes);
+
+    public:
+        explicit SnapshotWriter(std::ostream &strm) : strm(strm) {}
+
+        /**
+         * @brief Write up to 16 bits, a register or memory word.
+         */
+        void writeWord(uint64_t value) {
+            write(value, 2);
+        }
+
+        /**
+         * @brief Write a 64 bit count, such as a cycle count.
+         */
+        void writeCount(uint64_t value) {
+            write(value, 8);
+        }
+
+        void writeFlag(bool flag) {
+            write(flag ? 1u : 0u, 1);
+        }
+
+        /**
+         * @brief Write a length prefixed block of bytes.
+         */
+        void writeBlock(std::string_view block);
+    };
+
+    /**
+     * @class SnapshotReader
+     */
+    class SnapshotReader {
+    public:
+        static constexpr uint64_t MaxBlock = 1u << 24;     ///< The largest block accepted, guards against corruption.
+
+    protected:
+        std::istream &strm;
+
+        uint64_t read(unsigned int bytes);
+
+    public:
+        explicit SnapshotReader(std::istream &strm) : strm(strm) {}
+
+        uint16_t readWord() {
+            return static_cast<uint16_t>(read(2));
+        }
+
+        uint64_t readCount() {
+            return read(8);
+        }
+
+        bool readFlag() {
+            return read(1) != 0;
+        }
+
+        std::string readBlock();
+
+        /**
+         * @brief True if every byte has been read.
+         */
+        bool atEnd() {
+            return strm.peek() == std::istream::traits_type::eof();
+        }
+    };
+
+} // pdp8
+
+#endif //PDP8_SNAPSHOT_H
@@ -9,6 +9,9 @@
 #include <bits/socket.h>
 #include <arpa/inet.h>
 #include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <span>
 #include "Terminal.h"
 
 namespace pdp8 {
@@ -247,6 +250,75 @@ namespace pdp8 {
         }
     }
 
+    TerminalManager::TerminalManager() {
+        if (epollFd = epoll_create1(EPOLL_CLOEXEC); epollFd == -1)
+            throw TerminalConnectionException("epoll_create1 failed.");
+
+        if (eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK); eventFd == -1) {
+            close(epollFd);
+            throw TerminalConnectionException("eventfd failed.");
+        }
+
+        struct epoll_event event{};
+        event.events = EPOLLIN | EPOLLET;
+        event.data.fd = eventFd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &event) == -1) {
+            close(eventFd);
+            close(epollFd);
+            throw TerminalConnectionException("epoll_ctl failed.");
+        }
+    }
+
+    TerminalManager::~TerminalManager() {
+        close(eventFd);
+        close(epollFd);
+    }
+
+    void TerminalManager::watchTerminals() {
+        for (auto &term : *this) {
+            auto readFd = term->getReadFd();
+            auto writeFd = term->getWriteFd();
+            for (auto fd : {readFd, writeFd}) {
+                if (fd < 0 || watchedFds.contains(fd))
+                    continue;
+
+                struct epoll_event event{};
+                event.events = EPOLLET | EPOLLRDHUP;
+                if (fd == readFd)
+                    event.events |= EPOLLIN;
+                if (fd == writeFd)
+                    event.events |= EPOLLOUT;
+                event.data.fd = fd;
+                if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1)
+                    throw TerminalConnectionException("epoll_ctl failed.");
+                watchedFds.insert(fd);
+            }
+        }
+    }
+
+    void TerminalManager::unwatchTerminal(const TelnetTerminal &terminal) {
+        for (auto fd : {terminal.getReadFd(), terminal.getWriteFd()}) {
+            if (watchedFds.erase(fd))
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+    }
+
+    int TerminalManager::waitTimeout() const {
+        std::optional<clock::time_point> deadline{};
+        for (auto &term : *this) {
+            if (term->timerTick && term->tickDeadline && (!deadline || term->tickDeadline.value() < deadline.value()))
+                deadline = term->tickDeadline;
+        }
+
+        if (!deadline)
+            return -1;
+
+        auto now = clock::now();
+        if (deadline.value() <= now)
+            return 0;
+        return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(deadline.value() - now).count());
+    }
+
     void TerminalManager::serviceTerminals() {
         if (!service) {
             for (auto &term : *this) {
@@ -258,86 +330,67 @@ namespace pdp8 {
             return;
         }
 
-        std::this_thread::sleep_for(selectTimeout);
+        {
+            std::lock_guard guard{queueLock};
+            if (terminalQueue) {
+                push_back(std::move(terminalQueue));
+                terminalQueue.reset();
+            }
+        }
+
+        watchTerminals();
 
-        if (terminalQueue) {
-            push_back(std::move(terminalQueue));
-            terminalQueue.reset();
+        std::array<struct epoll_event, MaxEvents> events{};
+        auto count = epoll_wait(epollFd, events.data(), MaxEvents, waitTimeout());
+        if (count == -1) {
+            if (errno != EINTR)
+                throw TerminalConnectionException("Call to epoll_wait failed.");
+            count = 0;
         }
 
-        auto[timeoutRemainder, selectResults] = selectOnAll(selectTimeout);
-        for (auto const &selectResult: selectResults) {
-            bool disconnected{false};
-            if (selectResult.selectRead) {
-                if (at(selectResult.listIndex)->connection->iStrmBuf->in_avail() == 0) {
-                    if (at(selectResult.listIndex)->disconnectCallback)
-                        at(selectResult.listIndex)->disconnectCallback();
-                    disconnected = at(selectResult.listIndex)->disconnected = true;
-                }
+        for (auto const &event : std::span(events.data(), static_cast<std::size_t>(count))) {
+            if (event.data.fd == eventFd) {
+                uint64_t value;
+                posted = false;
+                while (::read(eventFd, &value, sizeof(value)) > 0) {}
+                continue;
             }
-            if (!disconnected && (selectResult.selectRead || selectResult.selectWrite)) {
-                [[maybe_unused]] auto c = at(static_cast<unsigned long>(selectResult.listIndex))->selected(selectResult.selectRead, selectResult.selectWrite);
+
+            for (auto &term : *this) {
+                auto isRead = term->getReadFd() == event.data.fd;
+                auto isWrite = term->getWriteFd() == event.data.fd;
+                if (term->disconnected || !(isRead || isWrite))
+                    continue;
+
+                bool selectRead = isRead && (event.events & EPOLLIN);
+                bool selectWrite = isWrite && (event.events & EPOLLOUT);
+                if (isRead && (event.events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                    // Input sent before the peer closed is still queued, read it before disconnecting.
+                    if (selectRead) {
+                        [[maybe_unused]] auto c = term->selected(true, false);
+                    }
+                    if (term->disconnectCallback)
+                        term->disconnectCallback();
+                    term->disconnected = true;
+                } else if (selectRead || selectWrite) {
+                    [[maybe_unused]] auto c = term->selected(selectRead, selectWrite);
+                }
             }
         }
 
         for (auto &term : *this) {
             if (!term->disconnected && term->timerTick) {
+                term->tickDeadline.reset();
                 term->disconnected = !term->timerTick();
             }
         }
 
         erase(std::remove_if(begin(), end(),
-                          [](const std::shared_ptr<TelnetTerminal> &t) {
+                          [this](const std::shared_ptr<TelnetTerminal> &t) {
+                              if (t->disconnected)
+                                  unwatchTerminal(*t);
                               return t->disconnected;
                           }), end());
-
-        std::this_thread::sleep_for(timeoutRemainder);
-    }
-
-    std::tuple<std::chrono::microseconds, std::vector<TerminalManager::SelectAllResult>>
-    TerminalManager::selectOnAll(std::chrono::microseconds timeoutUs) {
-
-        fd_set readFds, writeFds, exceptFds;
-        FD_ZERO(&readFds);
-        FD_ZERO(&writeFds);
-        FD_ZERO(&exceptFds);
-        struct timeval timeout{};
-
-        timeout.tv_sec = 0;
-        timeout.tv_usec = timeoutUs.count();
-
-        std::vector<SelectAllResult> selectResults{};
-
-        for (unsigned i = 0; i < size(); ++i) {
-            auto readFd = at(i)->getReadFd();
-            auto writeFd = at(i)->getWriteFd();
-            selectResults.emplace_back(i, readFd, writeFd, false, false, false);
-        }
-
-        for (auto const &selectResult: selectResults) {
-            if (selectResult.readFd >= 0) {
-                FD_SET(selectResult.readFd, &readFds);
-            }
-
-            if (selectResult.writeFd >= 0) {
-                FD_SET(selectResult.writeFd, &writeFds);
-            }
-        }
-
-        if (auto stat = ::select(FD_SETSIZE, &readFds, &writeFds, &exceptFds, &timeout); stat == -1) {
-            throw TerminalConnectionException("Call to select failed.");
-        } else if (stat > 0) {
-            for (auto &selectResult: selectResults) {
-                if (FD_ISSET(selectResult.readFd, &readFds))
-                    selectResult.selectRead = true;
-                if (FD_ISSET(selectResult.writeFd, &writeFds))
-                    selectResult.selectWrite = true;
-            }
-        }
-
-        std::chrono::microseconds timeoutRemainder{timeout.tv_usec};
-
-        return {timeoutRemainder, selectResults};
     }
 
 }
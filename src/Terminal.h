@@ -28,6 +28,10 @@
 #include <chrono>
 #include <thread>
 #include <functional>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <set>
 
 
 namespace pdp8 {
@@ -255,6 +259,12 @@ namespace pdp8 {
         std::function<bool()> timerTick{};
         std::function<void()> disconnectCallback{};
 
+        /**
+         * @brief When set the TerminalManager calls timerTick no later than this time, even if nothing else
+         * happens. It is cleared before each call to timerTick, and starts due so a new terminal is ticked at once.
+         */
+        std::optional<std::chrono::steady_clock::time_point> tickDeadline{std::chrono::steady_clock::time_point::min()};
+
         bool disconnected{false};
 
         std::string inputLineBuffer{};              ///< Buffer to read input from the user
@@ -324,52 +334,88 @@ namespace pdp8 {
     /**
      * @class TerminalManager
      * @brief Manages a collection of TelnetTerminals.
-     * @details The list of active terminals is scanned for activity using select(2). Terminals that need service
-     * are have their selected(bool selectRead, selectWrite) method called. Terminals that have been disconnected
-     * are marked for removal from the list. Finally each unmarked terminal which has set a timerTick callback will
-     * be called on the timerTick method. This provides an opportunity for the terminal to do internal processing
-     * which should be kept to much less than the selectTimeout period. Any terminal which returns false will be
-     * marked for removal. Finally all terminals marked for removal are removed.
+     * @details The file descriptors of the active terminals are watched with an edge triggered epoll(7) set, along
+     * with an eventfd(2) the CPU and devices write through post() when they have output for a terminal. The service
+     * loop sleeps until a terminal has input, something is posted, or the earliest terminal tickDeadline passes.
+     * Terminals that need service have their selected(bool selectRead, selectWrite) method called. Terminals that
+     * have been disconnected are marked for removal from the list. Finally each unmarked terminal which has set a
+     * timerTick callback will be called on the timerTick method. Any terminal which returns false will be marked
+     * for removal. Finally all terminals marked for removal are removed.
      */
     class TerminalManager : public std::vector<std::shared_ptr<TelnetTerminal>> {
     public:
-        std::shared_ptr<TelnetTerminal> terminalQueue{};
+        using clock = std::chrono::steady_clock;
 
     protected:
-        bool service{true};
+        static constexpr int MaxEvents = 16;     ///< Events collected by one epoll_wait(2).
 
-        std::chrono::microseconds selectTimeout{1000};
-        struct SelectAllResult {
-            unsigned long listIndex{static_cast<unsigned long>(-1)};
-            int readFd{-1}, writeFd{-1};
-            bool selectRead{false};
-            bool selectWrite{false};
-            bool selectExcept{false};
+        std::mutex queueLock{};
+        std::shared_ptr<TelnetTerminal> terminalQueue{};
 
-            SelectAllResult() = default;
+        std::atomic_bool service{true};
 
-            SelectAllResult(int idx, int read, int write, bool readSel, bool writeSel, bool exceptSel)
-                    : listIndex(idx), readFd(read), writeFd(write), selectRead(readSel), selectWrite(writeSel),
-                      selectExcept(exceptSel) {}
-        };
+        int epollFd{-1};                    ///< The epoll instance.
+        int eventFd{-1};                    ///< Written by post() to wake the service loop.
+        std::atomic_bool posted{false};     ///< True while a post() has not been consumed by the service loop.
+        std::set<int> watchedFds{};         ///< Terminal file descriptors added to the epoll set.
+
+        /**
+         * @brief Add the file descriptors of terminals not yet in the epoll set.
+         */
+        void watchTerminals();
+
+        /**
+         * @brief Remove the file descriptors of a terminal from the epoll set.
+         */
+        void unwatchTerminal(const TelnetTerminal &terminal);
 
         /**
-         * @brief Perform select(2) on all terminals file descriptors, waiting for the provided timeout.
-         * @param timeoutUs The wait timeout duration.
-         * @return A tuple with the time remaining from the timeout and a list of terminals which need service.
+         * @brief The epoll_wait(2) timeout in milliseconds to the earliest terminal tickDeadline, -1 if none.
          */
-        std::tuple<std::chrono::microseconds, std::vector<SelectAllResult>>
-        selectOnAll(std::chrono::microseconds timeoutUs);
+        int waitTimeout() const;
 
     public:
+        TerminalManager();
+        TerminalManager(const TerminalManager &) = delete;
+        TerminalManager(TerminalManager &&) = delete;
+        TerminalManager &operator=(const TerminalManager &) = delete;
+        TerminalManager &operator=(TerminalManager &&) = delete;
+
+        ~TerminalManager();
+
         void closeAll() {
             service = false;
+            post();
+        }
+
+        /**
+         * @brief Wake the service loop so terminals are serviced, and timerTick called, without waiting.
+         * @details May be called from any thread. Posts made before the service loop wakes are coalesced into one
+         * write to the eventfd.
+         */
+        void post() {
+            if (!posted.exchange(true)) {
+                uint64_t one = 1;
+                [[maybe_unused]] auto n = ::write(eventFd, &one, sizeof(one));
+            }
+        }
+
+        /**
+         * @brief Queue a terminal to be added to the managed list on the next service pass.
+         * @details May be called from any thread, for example by a device on the CPU execution thread.
+         * @param terminal The terminal to add.
+         */
+        void queueTerminal(std::shared_ptr<TelnetTerminal> terminal) {
+            {
+                std::lock_guard guard{queueLock};
+                terminalQueue = std::move(terminal);
+            }
+            post();
         }
 
         /**
-         * @brief Service the list of terminals. This should be called regularly in the application event loop
-         * on the main thread. The method will consume at least selectTimeout microseconds which can be used to
-         * set the tempo of the program.
+         * @brief Service the list of terminals. This should be called repeatedly in the application event loop
+         * on the main thread. The method sleeps until there is input, a post() or a terminal tickDeadline.
          */
         void serviceTerminals();
 
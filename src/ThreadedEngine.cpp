@@ -0,0 +1,92 @@
+/*
+ * ThreadedEngine.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file ThreadedEngine.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief The direct threaded interpreter selected by PDP8::ExecutionEngine::Threaded.
+ * @details Each opcode handler ends with its own copy of the dispatch sequence, which jumps straight to the
+ * handler for the next instruction through a table of label addresses. Replicating the indirect jump gives the
+ * branch predictor one history per handler rather than the single shared jump of the switch in PDP8::execute().
+ * Labels as values are a GNU extension, supported by GCC and Clang, which the project already relies on. The
+ * opcode handlers themselves are shared with PDP8::execute() so the two engines can not drift apart.
+ *
+ * tests/bm_Engines measures this engine within a few percent of the switch on x86-64, whose indirect branch
+ * predictor already tells the switch's targets apart; the replicated dispatch is for simpler cores.
+ */
+
+#include "PDP8.h"
+#include "OprMicrocode.h"
+
+namespace pdp8 {
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+    PDP8::RunExit PDP8::runThreaded(unsigned long count, unsigned long maxInstructions) {
+        const DecodedInstruction *decoded;
+
+        /*
+         * The dispatch sequence: stop at the end of the batch, on halt, when waiting for a device or at a
+         * breakpoint, otherwise fetch the next instruction, complete any defer cycle and jump to the handler for
+         * its opcode.
+         */
+#define PDP8_FETCH()                                    \
+        if (count >= maxInstructions)                   \
+            goto budget;                                \
+        if (!run_flag)                                  \
+            return RunExit::Halt;                       \
+        if (!interruptCheck())                          \
+            return RunExit::IdleWait;                   \
+        if (breakpointBefore())                         \
+            return RunExit::Breakpoint;                 \
+        ++count;                                        \
+        decoded = &fetchDecoded();                      \
+        if (decoded->isIndirect())                      \
+            defer(*decoded)
+
+        static constexpr void *handlers[] = {&&op_and, &&op_tad, &&op_isz, &&op_dca,
+                                             &&op_jms, &&op_jmp, &&op_iot, &&op_opr};
+#define PDP8_DISPATCH() retire(decoded->isIndirect()); PDP8_FETCH(); goto *handlers[static_cast<unsigned>(decoded->opCode)]
+
+        PDP8_FETCH();
+        goto *handlers[static_cast<unsigned>(decoded->opCode)];
+
+    op_and:
+        executeAnd();
+        PDP8_DISPATCH();
+    op_tad:
+        executeTad();
+        PDP8_DISPATCH();
+    op_isz:
+        executeIsz();
+        PDP8_DISPATCH();
+    op_dca:
+        executeDca();
+        PDP8_DISPATCH();
+    op_jms:
+        executeJms();
+        PDP8_DISPATCH();
+    op_jmp:
+        executeJmp();
+        PDP8_DISPATCH();
+    op_iot:
+        execute_iot();
+        PDP8_DISPATCH();
+    op_opr:
+        OprTable[instructionReg.getOprBits()](*this);
+        PDP8_DISPATCH();
+
+#undef PDP8_DISPATCH
+#undef PDP8_FETCH
+
+    budget:
+        return run_flag ? RunExit::BudgetExhausted : RunExit::Halt;
+    }
+
+#pragma GCC diagnostic pop
+
+} // pdp8
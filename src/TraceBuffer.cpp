@@ -0,0 +1,90 @@
+/*
+ * TraceBuffer.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file TraceBuffer.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "TraceBuffer.h"
+#include "Snapshot.h"
+#include <bit>
+#include <string>
+
+namespace pdp8 {
+
+    TraceBuffer::TraceBuffer(std::size_t capacity)
+            : mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+              slots(std::make_unique<Slot[]>(mask + 1)) {}
+
+    std::vector<TraceRecord> TraceBuffer::records() const {
+        auto end = added.load(std::memory_order_acquire);
+        auto begin = end > capacity() ? end - capacity() : 0;
+
+        std::vector<TraceRecord> copy{};
+        copy.reserve(static_cast<std::size_t>(end - begin));
+        for (auto index = begin; index < end; ++index) {
+            auto &slot = slots[index & mask];
+            auto sequence = slot.sequence.load(std::memory_order_acquire);
+            auto registers = slot.registers.load(std::memory_order_relaxed);
+            auto mulQuotient = slot.mulQuotient.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence != 2 * index + 2 || slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                // The CPU is writing or has overwritten this record, and so every older one copied.
+                copy.clear();
+                continue;
+            }
+            copy.push_back(TraceRecord{static_cast<uint16_t>(registers), static_cast<uint16_t>(registers >> 16u),
+                                       static_cast<uint16_t>(registers >> 32u),
+                                       static_cast<uint16_t>(registers >> 48u),
+                                       static_cast<uint16_t>(mulQuotient)});
+        }
+        return copy;
+    }
+
+    void TraceBuffer::dump(std::ostream &strm) const {
+        auto copy = records();
+        strm.write(Magic.data(), static_cast<std::streamsize>(Magic.size()));
+        SnapshotWriter writer{strm};
+        writer.writeWord(Version);
+        writer.writeCount(copy.size());
+        for (auto &record: copy) {
+            writer.writeWord(record.location);
+            writer.writeWord(record.instruction);
+            writer.writeWord(record.address);
+            writer.writeWord(record.arithmetic);
+            writer.writeWord(record.mulQuotient);
+        }
+        if (!strm)
+            throw SnapshotError("Trace could not be written.");
+    }
+
+    std::vector<TraceRecord> TraceBuffer::read(std::istream &strm) {
+        std::string magic(Magic.size(), '\0');
+        if (!strm.read(magic.data(), static_cast<std::streamsize>(magic.size())) || magic != Magic)
+            throw SnapshotError("Not a PDP8 trace.");
+        SnapshotReader reader{strm};
+        if (reader.readWord() != Version)
+            throw SnapshotError("Unsupported trace version.");
+        auto count = reader.readCount();
+        if (count > SnapshotReader::MaxBlock)
+            throw SnapshotError("Trace is too large.");
+
+        std::vector<TraceRecord> records{};
+        records.reserve(static_cast<std::size_t>(count));
+        for (uint64_t idx = 0; idx < count; ++idx) {
+            TraceRecord record{};
+            record.location = reader.readWord();
+            record.instruction = reader.readWord();
+            record.address = reader.readWord();
+            record.arithmetic = reader.readWord();
+            record.mulQuotient = reader.readWord();
+            records.push_back(record);
+        }
+        return records;
+    }
+
+} // pdp8
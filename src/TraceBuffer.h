@@ -0,0 +1,122 @@
+/*
+ * TraceBuffer.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file TraceBuffer.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief A ring buffer of the most recently executed instructions, for post mortem debugging.
+ * @details The CPU thread adds a record after each instruction and another thread may dump the buffer at any
+ * time without a lock. Each slot is a seqlock: its sequence is odd while the CPU writes the record and even, two
+ * more than twice the record's index, once it is complete. A dump keeps a record only if the slot held that record
+ * before and after it was copied, so a record the CPU was writing or overwrote is dropped along with every older
+ * one, leaving the most recent records in order.
+ *
+ * A dump is written in a compact binary form: the magic "PDP8TRAC", a 16 bit version, a 64 bit record count,
+ * then each record as five little endian 16 bit words in the order of TraceRecord, oldest first. The pdp8trace
+ * tool disassembles a dump.
+ */
+
+#ifndef PDP8_TRACEBUFFER_H
+#define PDP8_TRACEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace pdp8 {
+
+    /**
+     * @brief An executed instruction. Locations are 15 bit field and address.
+     */
+    struct TraceRecord {
+        uint16_t location{0};           ///< Where the instruction was fetched from.
+        uint16_t instruction{0};
+        uint16_t address{0};            ///< The effective address, meaningful for memory reference instructions.
+        uint16_t arithmetic{0};         ///< Link and AC after the instruction.
+        uint16_t mulQuotient{0};        ///< MQ after the instruction.
+
+        bool operator==(const TraceRecord &) const = default;
+    };
+
+    /**
+     * @class TraceBuffer
+     */
+    class TraceBuffer {
+    public:
+        static constexpr std::string_view Magic = "PDP8TRAC";
+        static constexpr uint16_t Version = 1;
+        static constexpr std::size_t DefaultCapacity = 1u << 16;
+
+    protected:
+        struct Slot {
+            std::atomic<uint64_t> sequence{0};      ///< 2 * index + 1 while written, 2 * index + 2 after.
+            std::atomic<uint64_t> registers{0};     ///< location, instruction, address and arithmetic.
+            std::atomic<uint64_t> mulQuotient{0};
+        };
+
+        std::size_t mask;
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<uint64_t> added{0};
+
+    public:
+        /**
+         * @param capacity The number of records kept, rounded up to a power of two.
+         */
+        explicit TraceBuffer(std::size_t capacity = DefaultCapacity);
+
+        [[nodiscard]] std::size_t capacity() const {
+            return mask + 1;
+        }
+
+        /**
+         * @brief Add a record, call only on the CPU thread.
+         */
+        void add(const TraceRecord &record) {
+            auto index = added.load(std::memory_order_relaxed);
+            auto &slot = slots[index & mask];
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.registers.store(static_cast<uint64_t>(record.location)
+                                 | static_cast<uint64_t>(record.instruction) << 16u
+                                 | static_cast<uint64_t>(record.address) << 32u
+                                 | static_cast<uint64_t>(record.arithmetic) << 48u, std::memory_order_relaxed);
+            slot.mulQuotient.store(record.mulQuotient, std::memory_order_relaxed);
+            slot.sequence.store(2 * index + 2, std::memory_order_release);
+            added.store(index + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief The number of records added since the buffer was created.
+         */
+        [[nodiscard]] uint64_t count() const {
+            return added.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Copy the records held, oldest first. May be called on any thread.
+         */
+        [[nodiscard]] std::vector<TraceRecord> records() const;
+
+        /**
+         * @brief Write the records held in the binary dump format. May be called on any thread.
+         * @throws SnapshotError if the stream fails.
+         */
+        void dump(std::ostream &strm) const;
+
+        /**
+         * @brief Read a binary dump.
+         * @throws SnapshotError if the stream is not a trace dump or is damaged.
+         */
+        static std::vector<TraceRecord> read(std::istream &strm);
+    };
+
+} // pdp8
+
+#endif //PDP8_TRACEBUFFER_H
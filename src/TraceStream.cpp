@@ -0,0 +1,218 @@
+/*
+ * TraceStream.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file TraceStream.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "TraceStream.h"
+#include "Snapshot.h"
+#include <fmt/format.h>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace pdp8 {
+
+    namespace {
+        /**
+         * @brief Store a little endian word if size is 2. The word is always written.
+         */
+        char *put(char *out, uint16_t value, unsigned int size) {
+            std::array<char, 2> bytes{static_cast<char>(value & 0xFFu), static_cast<char>(value >> 8u)};
+            std::memcpy(out, bytes.data(), bytes.size());
+            return out + size;
+        }
+
+        uint16_t get(std::string_view buffer, std::size_t &position) {
+            auto value = static_cast<uint16_t>(static_cast<unsigned char>(buffer[position])
+                                               | static_cast<unsigned char>(buffer[position + 1]) << 8u);
+            position += 2;
+            return value;
+        }
+
+        /**
+         * @brief Location, instruction, address and L/AC as the four 16 bit lanes of a word.
+         */
+        uint64_t lanes(uint16_t location, uint32_t operation, uint16_t arithmetic) {
+            return location | static_cast<uint64_t>(operation) << 16u | static_cast<uint64_t>(arithmetic) << 48u;
+        }
+
+        /**
+         * @brief A bit for each non zero 16 bit lane of a word, without branches.
+         */
+        unsigned int nonZeroLanes(uint64_t word) {
+            static constexpr uint64_t Low = 0x7FFF7FFF7FFF7FFFu;
+            static constexpr uint64_t High = 0x8000800080008000u;
+            auto nonZero = ((((word & Low) + Low) | word) & High) >> 15u;
+            // Gather the bits at 0, 16, 32 and 48 into bits 48 to 51.
+            return static_cast<unsigned int>((nonZero * 0x0001000200040008u) >> 48u) & 0xFu;
+        }
+    }
+
+    char *TraceDelta::encode(std::span<const TraceRecord> records, char *out) {
+        // The predictions are held in locals as the stores through out could alias them. Fields are compared in
+        // one word and sizes computed rather than branched on, the fields that change follow the program's data.
+        auto last = previous;
+        auto *operation = operations.data();
+        for (auto &record: records) {
+            auto location = static_cast<std::size_t>(record.location & (Locations - 1u));
+            auto decoded = static_cast<uint32_t>(record.instruction | record.address << 16u);
+            auto predicted = lanes(static_cast<uint16_t>((last.location + 1u) & (Locations - 1u)),
+                                   operation[location], last.arithmetic);
+            auto flags = nonZeroLanes(lanes(record.location, decoded, record.arithmetic) ^ predicted)
+                         | static_cast<unsigned int>(record.mulQuotient != last.mulQuotient) << 4u;
+            operation[location] = decoded;
+            last = record;
+
+            *out++ = static_cast<char>(flags);
+            out = put(out, record.location, (flags & LocationChanged) << 1u);
+            out = put(out, record.instruction, flags & InstructionChanged);
+            out = put(out, record.address, (flags & AddressChanged) >> 1u);
+            out = put(out, record.arithmetic, (flags & ArithmeticChanged) >> 2u);
+            out = put(out, record.mulQuotient, (flags & MulQuotientChanged) >> 3u);
+        }
+        previous = last;
+        return out;
+    }
+
+    TraceRecord TraceDelta::decode(std::string_view buffer, std::size_t &position) {
+        if (position >= buffer.size())
+            throw SnapshotError("Trace stream is truncated.");
+        auto flags = static_cast<unsigned int>(static_cast<unsigned char>(buffer[position++]));
+        if (flags & ~0x1Fu)
+            throw SnapshotError("Trace stream is damaged.");
+        if (buffer.size() - position < 2u * static_cast<unsigned int>(std::popcount(flags)))
+            throw SnapshotError("Trace stream is truncated.");
+
+        TraceRecord record{};
+        record.location = (flags & LocationChanged) ? get(buffer, position) : nextLocation();
+        if (record.location >= Locations)
+            throw SnapshotError("Trace stream is damaged.");
+        auto &operation = operations[record.location];
+        record.instruction = (flags & InstructionChanged) ? get(buffer, position)
+                                                          : static_cast<uint16_t>(operation);
+        record.address = (flags & AddressChanged) ? get(buffer, position) : static_cast<uint16_t>(operation >> 16u);
+        record.arithmetic = (flags & ArithmeticChanged) ? get(buffer, position) : previous.arithmetic;
+        record.mulQuotient = (flags & MulQuotientChanged) ? get(buffer, position) : previous.mulQuotient;
+        operation = static_cast<uint32_t>(record.instruction | record.address << 16u);
+        previous = record;
+        return record;
+    }
+
+    TraceStreamWriter::TraceStreamWriter(const std::filesystem::path &path)
+            : file(path, std::ios::binary | std::ios::trunc) {
+        if (!file)
+            throw std::runtime_error(fmt::format("Can not create trace stream {}", path.string()));
+        file.write(TraceDelta::Magic.data(), static_cast<std::streamsize>(TraceDelta::Magic.size()));
+        SnapshotWriter{file}.writeWord(TraceDelta::Version);
+
+        for (std::size_t idx = 0; idx < PoolBlocks; ++idx)
+            pool.push_back(std::make_unique<Block>());
+        current = pool.front().get();
+        for (auto block = pool.begin() + 1; block != pool.end(); ++block)
+            emptied.push(block->get());
+
+        writerThread = std::jthread([this] { writer(); });
+    }
+
+    TraceStreamWriter::~TraceStreamWriter() {
+        close();
+    }
+
+    bool TraceStreamWriter::close() {
+        if (!writerThread.joinable())
+            return !failed;
+        // The pool is no larger than the filled ring so there is always room for the last block.
+        if (current->count)
+            filled.push(current);
+        closing.store(true, std::memory_order_release);
+        filledCount.fetch_add(1, std::memory_order_release);
+        filledCount.notify_one();
+        writerThread.join();
+        file.close();
+        return !failed && file;
+    }
+
+    void TraceStreamWriter::submit() {
+        recordCount += current->count;
+        filled.push(current);
+        filledCount.fetch_add(1, std::memory_order_release);
+        filledCount.notify_one();
+
+        while (emptied.pop(std::span{&current, 1}) == 0) {
+            auto seen = emptiedCount.load(std::memory_order_acquire);
+            if (emptied.pop(std::span{&current, 1}))
+                break;
+            emptiedCount.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    void TraceStreamWriter::writer() {
+        TraceDelta delta{};
+        auto buffer = std::make_unique<char[]>(BlockRecords * TraceDelta::MaxRecordSize);
+        SnapshotWriter snapshotWriter{file};
+
+        while (true) {
+            auto seen = filledCount.load(std::memory_order_acquire);
+            auto last = closing.load(std::memory_order_acquire);
+            Block *block{nullptr};
+            if (filled.pop(std::span{&block, 1}) == 0) {
+                if (last)
+                    break;
+                filledCount.wait(seen, std::memory_order_acquire);
+                continue;
+            }
+
+            if (!failed.load(std::memory_order_relaxed)) {
+                auto end = delta.encode({block->records.data(), block->count}, buffer.get());
+                snapshotWriter.writeCount(block->count);
+                snapshotWriter.writeBlock({buffer.get(), static_cast<std::size_t>(end - buffer.get())});
+                if (!file)
+                    failed.store(true, std::memory_order_relaxed);
+            }
+
+            block->count = 0;
+            emptied.push(block);
+            emptiedCount.fetch_add(1, std::memory_order_release);
+            emptiedCount.notify_one();
+        }
+
+        file.flush();
+        if (!file)
+            failed.store(true, std::memory_order_relaxed);
+    }
+
+    TraceStreamReader::TraceStreamReader(std::istream &strm) : strm(strm) {
+        std::string magic(TraceDelta::Magic.size(), '\0');
+        if (!strm.read(magic.data(), static_cast<std::streamsize>(magic.size())) || magic != TraceDelta::Magic)
+            throw SnapshotError("Not a PDP8 trace stream.");
+        if (SnapshotReader{strm}.readWord() != TraceDelta::Version)
+            throw SnapshotError("Unsupported trace stream version.");
+    }
+
+    bool TraceStreamReader::next(TraceRecord &record) {
+        while (remaining == 0) {
+            if (position != block.size())
+                throw SnapshotError("Trace stream is damaged.");
+            if (strm.peek() == std::istream::traits_type::eof())
+                return false;
+            SnapshotReader reader{strm};
+            remaining = reader.readCount();
+            block = reader.readBlock();
+            position = 0;
+            if (remaining > block.size())
+                throw SnapshotError("Trace stream is damaged.");
+        }
+
+        record = delta.decode(block, position);
+        --remaining;
+        return true;
+    }
+
+} // pdp8
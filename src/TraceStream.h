@@ -0,0 +1,195 @@
+/*
+ * TraceStream.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file TraceStream.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief A complete trace of execution streamed to a file, for comparing runs of billions of instructions.
+ * @details The CPU thread copies each TraceRecord into a block from a fixed pool. Full blocks pass to a writer
+ * thread through a RingBuffer and return through another once written, so the CPU only waits if the disk falls a
+ * whole pool behind.
+ *
+ * The writer delta encodes each record against what it predicts from the one before: the following location,
+ * the instruction and effective address last seen at that location, and unchanged L/AC and MQ. A record is a
+ * flags byte, one bit for each field in TraceRecord order that differs from its prediction, followed by those
+ * fields as little endian words. The encoder compares the fields and sizes the record without branches so the
+ * writer keeps up when it shares a core with the CPU. A loop costs two to three bytes an instruction.
+ *
+ * The file is the magic "PDP8STRM" and a 16 bit version, then blocks, each a 64 bit record count and the length
+ * prefixed encoded records, written with SnapshotWriter. The predictions carry from one block to the next.
+ */
+
+#ifndef PDP8_TRACESTREAM_H
+#define PDP8_TRACESTREAM_H
+
+#include <TraceBuffer.h>
+#include <RingBuffer.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pdp8 {
+
+    /**
+     * @class TraceDelta
+     * @brief The predictions shared by the trace stream encoder and decoder.
+     */
+    class TraceDelta {
+    public:
+        static constexpr std::string_view Magic = "PDP8STRM";
+        static constexpr uint16_t Version = 1;
+
+        static constexpr unsigned int LocationChanged = 0x01u;
+        static constexpr unsigned int InstructionChanged = 0x02u;
+        static constexpr unsigned int AddressChanged = 0x04u;
+        static constexpr unsigned int ArithmeticChanged = 0x08u;
+        static constexpr unsigned int MulQuotientChanged = 0x10u;
+
+        static constexpr std::size_t MaxRecordSize = 11;   ///< The flags and five words.
+
+    protected:
+        static constexpr std::size_t Locations = 0100000;
+
+        TraceRecord previous{};
+        std::vector<uint32_t> operations = std::vector<uint32_t>(Locations);    ///< Instruction and address.
+
+        [[nodiscard]] uint16_t nextLocation() const {
+            return static_cast<uint16_t>((previous.location + 1u) & (Locations - 1u));
+        }
+
+    public:
+        /**
+         * @brief Encode records and update the predictions.
+         * @param out Where to write the encoding, with room for MaxRecordSize bytes a record.
+         * @return The end of the encoding.
+         */
+        char *encode(std::span<const TraceRecord> records, char *out);
+
+        /**
+         * @brief Decode a record from a buffer and update the predictions.
+         * @param position The offset of the record, advanced past it.
+         * @throws SnapshotError if the buffer is damaged.
+         */
+        TraceRecord decode(std::string_view buffer, std::size_t &position);
+    };
+
+    /**
+     * @class TraceStreamWriter
+     */
+    class TraceStreamWriter {
+    public:
+        static constexpr std::size_t BlockRecords = 1u << 14;
+        static constexpr std::size_t PoolBlocks = 8;
+
+    protected:
+        struct Block {
+            std::array<TraceRecord, BlockRecords> records{};
+            std::size_t count{0};
+        };
+
+        std::ofstream file;
+        std::vector<std::unique_ptr<Block>> pool{};
+        RingBuffer<Block *, PoolBlocks> filled{};       ///< CPU thread to writer thread.
+        RingBuffer<Block *, PoolBlocks> emptied{};      ///< Writer thread to CPU thread.
+        std::atomic<uint64_t> filledCount{0};           ///< Advanced and notified when a block is filled.
+        std::atomic<uint64_t> emptiedCount{0};          ///< Advanced and notified when a block is written.
+        std::atomic_bool closing{false};
+        std::atomic_bool failed{false};
+
+        Block *current{nullptr};
+        uint64_t recordCount{0};
+
+        std::jthread writerThread;
+
+        /**
+         * @brief Pass the current block to the writer thread and take an empty one, waiting if there is none.
+         */
+        void submit();
+
+        void writer();
+
+    public:
+        /**
+         * @brief Create the trace file and start the writer thread.
+         * @throws std::runtime_error if the file can not be created.
+         */
+        explicit TraceStreamWriter(const std::filesystem::path &path);
+
+        TraceStreamWriter(const TraceStreamWriter&) = delete;
+        TraceStreamWriter(TraceStreamWriter&&) = delete;
+        TraceStreamWriter& operator=(const TraceStreamWriter&) = delete;
+        TraceStreamWriter& operator=(TraceStreamWriter&&) = delete;
+
+        ~TraceStreamWriter();
+
+        /**
+         * @brief Write the remaining records, stop the writer thread and close the file. No more records may be
+         * added.
+         * @return False if writing the file failed.
+         */
+        bool close();
+
+        /**
+         * @brief Add a record, call only on the CPU thread.
+         */
+        void add(const TraceRecord &record) {
+            current->records[current->count] = record;
+            if (++current->count == BlockRecords) [[unlikely]]
+                submit();
+        }
+
+        /**
+         * @brief The number of records added.
+         */
+        [[nodiscard]] uint64_t count() const {
+            return recordCount + current->count;
+        }
+
+        /**
+         * @brief True if writing the file failed, records added since have been lost.
+         */
+        [[nodiscard]] bool hasFailed() const {
+            return failed;
+        }
+    };
+
+    /**
+     * @class TraceStreamReader
+     * @brief Iterate the records of a trace stream a block at a time.
+     */
+    class TraceStreamReader {
+    protected:
+        std::istream &strm;
+        TraceDelta delta{};
+        std::string block{};
+        std::size_t position{0};
+        uint64_t remaining{0};      ///< Records left in the current block.
+
+    public:
+        /**
+         * @throws SnapshotError if the stream is not a trace stream.
+         */
+        explicit TraceStreamReader(std::istream &strm);
+
+        /**
+         * @brief Read the next record.
+         * @return False at the end of the trace.
+         * @throws SnapshotError if the trace is damaged.
+         */
+        bool next(TraceRecord &record);
+    };
+
+} // pdp8
+
+#endif //PDP8_TRACESTREAM_H
@@ -0,0 +1,123 @@
+/*
+ * Disassembler.cpp Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Disassembler.cpp
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ */
+
+#include "Disassembler.h"
+#include <fmt/format.h>
+#include <optional>
+#include <vector>
+
+namespace pdp8asm {
+
+    namespace {
+        /**
+         * @brief Find the mnemonic of an op code of a combination type in the InstructionSet.
+         */
+        std::optional<std::string_view> mnemonic(word_t opCode, CombinationType type) {
+            for (const auto &instruction: InstructionSet)
+                if (instruction.opCode == opCode && instruction.orCombination == type)
+                    return instruction.mnemonic;
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Add the mnemonics for each bit of an operate instruction to parts.
+         * @return False if a bit has no mnemonic.
+         */
+        bool microcode(word_t word, word_t base, std::initializer_list<word_t> bits, CombinationType type,
+                       std::vector<std::string_view> &parts) {
+            for (auto bit: bits) {
+                if (word & bit) {
+                    auto name = mnemonic(static_cast<word_t>(base | bit), type);
+                    if (!name)
+                        return false;
+                    parts.push_back(name.value());
+                }
+            }
+            return true;
+        }
+    }
+
+    Disassembler::Disassembler(const std::map<std::string, Symbol> &symbolTable) {
+        for (const auto &[name, symbol]: symbolTable)
+            if (symbol.status == Defined)
+                labels.emplace(symbol.value, name);
+    }
+
+    const std::string *Disassembler::label(word_t address) const {
+        if (auto found = labels.find(address); found != labels.end())
+            return &found->second;
+        return nullptr;
+    }
+
+    std::string Disassembler::addressName(word_t address) const {
+        if (auto name = label(address); name)
+            return *name;
+        return fmt::format("{:04o}", address);
+    }
+
+    std::string Disassembler::disassemble(word_t word, word_t address) const {
+        static constexpr std::array<std::string_view, 6> MemoryReference{"AND", "TAD", "ISZ", "DCA", "JMS", "JMP"};
+
+        word &= 07777u;
+        auto octal = fmt::format("{:04o}", word);
+        auto opCode = static_cast<std::size_t>(word >> 9u);
+        if (opCode < MemoryReference.size()) {
+            auto target = static_cast<word_t>(word & 0177u);
+            if (word & 0200u)
+                target |= static_cast<word_t>(address & 07600u);
+            return fmt::format("{}{} {}", MemoryReference[opCode], (word & 0400u) ? " I" : "", addressName(target));
+        }
+
+        if (opCode == 6) {
+            if (auto name = mnemonic(word, Iot); name)
+                return std::string{name.value()};
+            if (auto name = mnemonic(word, Memory); name)
+                return std::string{name.value()};
+            return octal;
+        }
+
+        std::vector<std::string_view> parts{};
+        bool known;
+        if ((word & 0400u) == 0) {
+            // Group 1: the clears, complements and increment, then a rotate.
+            known = microcode(word, 07000, {0200}, Gr, parts)
+                    && microcode(word, 07000, {0100, 0040, 0020, 0001}, Gr1, parts);
+            if (auto rotate = static_cast<word_t>(word & 0016u); known && rotate != 0) {
+                auto name = mnemonic(static_cast<word_t>(07000u | rotate), Gr1);
+                known = name.has_value();
+                if (known)
+                    parts.push_back(name.value());
+            }
+        } else if ((word & 0001u) == 0) {
+            // Group 2: the skips, sensed as an OR or an AND group, then CLA, OSR and HLT.
+            auto skips = (word & 0010u) ? Gr2And : Gr2Or;
+            auto base = static_cast<word_t>(07400u | (word & 0010u));
+            known = (word & 0160u) != 0 || (word & 0010u) == 0;
+            known = known && microcode(word, base, {0100, 0040, 0020}, skips, parts)
+                    && microcode(word, 07000, {0200}, Gr, parts)
+                    && microcode(word, 07400, {0004, 0002}, Gr2, parts);
+        } else {
+            // Group 3, without the EAE.
+            known = (word & 0056u) == 0 && microcode(word, 07000, {0200}, Gr, parts)
+                    && microcode(word, 07401, {0100, 0020}, Gr3, parts);
+        }
+
+        if (!known)
+            return octal;
+        if (parts.empty())
+            return "NOP";
+        std::string source{parts.front()};
+        for (auto part = parts.begin() + 1; part != parts.end(); ++part)
+            source += fmt::format(" {}", *part);
+        return source;
+    }
+
+} // pdp8asm
@@ -0,0 +1,62 @@
+/*
+ * Disassembler.h Created by Richard Buckley (C) 17/10/26
+ */
+
+/**
+ * @file Disassembler.h
+ * @author Richard Buckley <richard.buckley@ieee.org>
+ * @version 1.0
+ * @date 17/10/26
+ * @brief Convert instruction words back to PAL source.
+ * @details Mnemonics come from the assembler InstructionSet. Memory reference addresses are shown with the label
+ * from a symbol table when one has that value, otherwise in octal. Words with no mnemonic form are shown in octal.
+ */
+
+#ifndef PDP8_DISASSEMBLER_H
+#define PDP8_DISASSEMBLER_H
+
+#include "Assembler.h"
+#include <map>
+#include <string>
+
+namespace pdp8asm {
+
+    /**
+     * @class Disassembler
+     */
+    class Disassembler {
+    protected:
+        std::map<word_t, std::string> labels{};     ///< Label names by address.
+
+    public:
+        Disassembler() = default;
+
+        /**
+         * @brief Use the labels defined by an assembled program.
+         * @details Where several labels have the same value the first in alphabetical order is used.
+         * @param symbolTable The symbol table of an Assembler after pass 1.
+         */
+        explicit Disassembler(const std::map<std::string, Symbol> &symbolTable);
+
+        /**
+         * @brief The label for an address, if there is one.
+         */
+        [[nodiscard]] const std::string *label(word_t address) const;
+
+        /**
+         * @brief The label for an address, or the address in octal.
+         */
+        [[nodiscard]] std::string addressName(word_t address) const;
+
+        /**
+         * @brief Disassemble an instruction.
+         * @param word The instruction.
+         * @param address The address it was fetched from, which locates current page references.
+         * @return The instruction as PAL source, for example "TAD I Ptr" or "CLA CLL".
+         */
+        [[nodiscard]] std::string disassemble(word_t word, word_t address) const;
+    };
+
+} // pdp8asm
+
+#endif //PDP8_DISASSEMBLER_H
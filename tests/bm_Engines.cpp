@@ -0,0 +1,161 @@
+//
+// Created by richard on 17/10/26.
+//
+
+/*
+ * Benchmark the execution engines, Switch, Threaded and Block, on the same programs. Two small loops are built in,
+ * one dominated by control transfers and one by straight line code. PAL sources named on the command line, such as
+ * src/assembler/samples/DeepThought.pal, are run headless with the console and clock attached.
+ *
+ * bm_Engines [instructions] [program.pal ...]
+ */
+
+#include <HeadlessRunner.h>
+#include <PDP8.h>
+#include <assembler/Assembler.h>
+#include <fmt/format.h>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace pdp8;
+
+static constexpr std::string_view CountingLoop = R"(
+        OCTAL
+        *0200
+Start,  CLA CLL
+Loop,   TAD Val
+        IAC
+        DCA Val
+        ISZ Ctr
+        JMP Loop
+        ISZ Ctr2
+        JMP Loop
+        JMP Start
+Val,    0
+Ctr,    0
+Ctr2,   0
+        *Start
+)";
+
+static constexpr std::string_view StraightLine = R"(
+        OCTAL
+        *0010
+Index,  0
+        *0200
+Start,  CLA CLL
+        TAD TableM1
+        DCA Index
+        TAD Count
+        DCA Ctr
+Loop,   TAD I Index
+        RAL
+        TAD I Index
+        CIA
+        DCA Sum
+        TAD Sum
+        RTR
+        AND Mask
+        TAD I Index
+        DCA Sum
+        TAD Sum
+        BSW
+        TAD I Index
+        DCA I Index
+        ISZ Ctr
+        JMP Loop
+        JMP Start
+TableM1, Table-1
+Mask,   0377
+Sum,    0
+Ctr,    0
+Count,  7600
+        *1000
+Table,  0
+        *Start
+)";
+
+static constexpr std::array<std::pair<PDP8::ExecutionEngine, std::string_view>, 3> Engines{{
+        {PDP8::ExecutionEngine::Switch, "switch"},
+        {PDP8::ExecutionEngine::Threaded, "threaded"},
+        {PDP8::ExecutionEngine::Block, "block"},
+}};
+
+static double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief Run a built in program, which never halts, for a number of instructions.
+ * @return Millions of instructions per second.
+ */
+static double builtIn(std::string_view program, PDP8::ExecutionEngine engine, uint64_t instructions) {
+    auto pdp8 = std::make_unique<PDP8>(engine);
+    std::stringstream source{std::string(program)};
+    pdp8asm::Assembler assembler{};
+    assembler.readProgram(source);
+    std::stringstream bin{};
+    std::stringstream list{};
+    if (!assembler.pass1() || !assembler.pass2(bin, list) || !pdp8->readBinaryFormat(bin))
+        return 0.;
+
+    pdp8->set_run_flag(true);
+    auto start = std::chrono::steady_clock::now();
+    while (pdp8->getInstructionCount() < instructions && pdp8->get_run_flag())
+        pdp8->run(HeadlessRunner::BatchSize);
+    return static_cast<double>(pdp8->getInstructionCount()) / elapsedSeconds(start) / 1e6;
+}
+
+/**
+ * @brief Run a PAL source file headless until it stops or runs for a number of instructions.
+ * @return Millions of instructions per second.
+ */
+static double palFile(const std::string &path, PDP8::ExecutionEngine engine, uint64_t instructions) {
+    HeadlessOptions options{};
+    options.palFile = path;
+    options.inputFile = "/dev/null";
+    options.outputFile = "/dev/null";
+    options.budget = instructions;
+    options.engine = engine;
+    options.printRate = 0;
+    HeadlessRunner runner{options};
+    runner.load();
+    auto start = std::chrono::steady_clock::now();
+    runner.run();
+    return static_cast<double>(runner.getPdp8().getInstructionCount()) / elapsedSeconds(start) / 1e6;
+}
+
+template<class Run>
+void compare(std::string_view name, Run run) {
+    std::array<double, Engines.size()> rates{};
+    for (std::size_t idx = 0; idx < Engines.size(); ++idx)
+        rates[idx] = run(Engines[idx].first);
+    fmt::print("{}:\n", name);
+    for (std::size_t idx = 0; idx < Engines.size(); ++idx)
+        fmt::print("  {:9} {:7.2f} Minst/s  speed up: {:5.2f}x\n", Engines[idx].second, rates[idx],
+                   rates[idx] / rates[0]);
+}
+
+int main(int argc, char **argv) {
+    uint64_t instructions = argc > 1 ? std::stoull(argv[1]) : 100000000;
+
+    fmt::print("{} instructions per engine\n", instructions);
+    compare("Counting loop", [=](PDP8::ExecutionEngine engine) {
+        return builtIn(CountingLoop, engine, instructions);
+    });
+    compare("Straight line", [=](PDP8::ExecutionEngine engine) {
+        return builtIn(StraightLine, engine, instructions);
+    });
+    for (int arg = 2; arg < argc; ++arg) {
+        std::string path{argv[arg]};
+        compare(path, [&](PDP8::ExecutionEngine engine) {
+            return palFile(path, engine, instructions);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+//
+// Created by richard on 17/10/26.
+//
+
+/*
+ * Benchmark operate instruction dispatch: the branching PDP8::execute_opr() against the compile time
+ * generated OprTable handlers.
+ */
+
+#include <PDP8.h>
+#include <OprMicrocode.h>
+#include <fmt/format.h>
+#include <array>
+#include <chrono>
+#include <memory>
+
+using namespace pdp8;
+
+static constexpr std::array<uint16_t, 16> OprMix = {
+        07300, // CLA CLL
+        07004, // RAL
+        07010, // RAR
+        07041, // CIA
+        07440, // SZA
+        07510, // SPA
+        07650, // SNA CLA
+        07002, // BSW
+        07106, // CLL RTL
+        07421, // MQL
+        07501, // MQA
+        07521, // SWP
+        07420, // SNL
+        07240, // CLA CMA
+        07001, // IAC
+        07000, // NOP
+};
+
+template<class Dispatch>
+double nsPerInstruction(PDP8 &pdp8, unsigned long iterations, Dispatch dispatch) {
+    pdp8.accumulator.setAcc(01234);
+    pdp8.mulQuotient.setWord(04321);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        for (auto op: OprMix) {
+            pdp8.instructionReg.value = op;
+            dispatch(pdp8);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(iterations * OprMix.size());
+}
+
+int main(int argc, char **argv) {
+    unsigned long iterations = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    auto pdp8 = std::make_unique<PDP8>();
+
+    auto branching = nsPerInstruction(*pdp8, iterations, [](PDP8 &cpu) { cpu.execute_opr(); });
+    auto table = nsPerInstruction(*pdp8, iterations, [](PDP8 &cpu) {
+        OprTable[cpu.instructionReg.getOprBits()](cpu);
+    });
+
+    fmt::print("OPR dispatch, {} instructions each:\n", iterations * OprMix.size());
+    fmt::print("  branching execute_opr(): {:6.2f} ns/instruction\n", branching);
+    fmt::print("  generated OprTable:      {:6.2f} ns/instruction\n", table);
+    fmt::print("  speed up:                {:6.2f}x\n", branching / table);
+    return 0;
+}
@@ -3,12 +3,22 @@
 //
 
 #include <PDP8.h>
+#include <CpuRunner.h>
 #include <DK8_EA.h>
+#include <DK8_EP.h>
+#include <DECWriter.h>
+#include <PanelRenderer.h>
+#include <HeadlessRunner.h>
+#include <RingBuffer.h>
 #include <assembler/Assembler.h>
+#include <assembler/Disassembler.h>
 #include "libs/CodeFragmentTest.h"
 #include <clean-test/clean-test.h>
 #include <numeric>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 #include <utility>
 
 constexpr auto sum(auto... vs) { return (0 + ... + vs); }
@@ -445,7 +455,7 @@ auto const suite10 = ct::Suite{"DK8-EA", [] {
     "CLEI"_test = [] {
         Operate o("CLEI", [](Operate &opr) {
             auto dk8ea = std::make_shared<pdp8::DK8_EA>();
-            opr.pdp8.iotDevices[013] = dk8ea;
+            opr.pdp8.attachDevice(013, dk8ea);
         });
         auto dk8ea = std::dynamic_pointer_cast<DK8_EA>(o.pdp8.iotDevices[013]);
         ct::expect(o.opCode and ct::lift(dk8ea != nullptr) and dk8ea->enable_interrupt);
@@ -454,7 +464,7 @@ auto const suite10 = ct::Suite{"DK8-EA", [] {
         Operate o("CLDI", [](Operate &opr) {
             auto dk8ea = std::make_shared<pdp8::DK8_EA>();
             dk8ea->enable_interrupt = true;
-            opr.pdp8.iotDevices[013] = dk8ea;
+            opr.pdp8.attachDevice(013, dk8ea);
         });
         auto dk8ea = std::dynamic_pointer_cast<DK8_EA>(o.pdp8.iotDevices[013]);
         ct::expect(o.opCode and ct::lift(dk8ea != nullptr) and !dk8ea->enable_interrupt);
@@ -462,8 +472,8 @@ auto const suite10 = ct::Suite{"DK8-EA", [] {
     "CLSK"_test = [] {
         Operate o("CLSK", [](Operate &opr) {
             auto dk8ea = std::make_shared<pdp8::DK8_EA>();
-            std::this_thread::sleep_for(20ms);              // Wait enough time for the flag to be raised.
-            opr.pdp8.iotDevices[013] = dk8ea;
+            opr.pdp8.attachDevice(013, dk8ea);
+            dk8ea->setClockFlag(true);                      // As if a tick had passed.
         });
         auto dk8ea = std::dynamic_pointer_cast<DK8_EA>(o.pdp8.iotDevices[013]);
         ct::expect(
@@ -481,12 +491,28 @@ auto const suite10 = ct::Suite{"DK8-EA", [] {
         dk8ea->enable_interrupt = true;
         ct::expect(ct::lift(dk8ea->getInterruptRequest(0)));
     };
+    "Request Line"_test = [] {
+        auto pdp8 = std::make_unique<PDP8>();
+        auto dk8ea = std::make_shared<pdp8::DK8_EA>(false);
+        pdp8->attachDevice(013, dk8ea);
+        dk8ea->setServiceRequest(013);
+        auto disabled = pdp8->interruptRequests->pending();
+        dk8ea->operation(*pdp8, 013, 1);        // CLEI
+        auto enabled = pdp8->interruptRequests->test(013);
+        dk8ea->operation(*pdp8, 013, 3);        // CLSK
+        ct::expect(ct::lift(!disabled) and ct::lift(enabled) and ct::lift(!pdp8->interruptRequests->pending()));
+    };
     "Time"_test = [] {
+        auto pdp8 = std::make_unique<PDP8>();
         auto dk8ea = std::make_shared<pdp8::DK8_EA>();
+        pdp8->attachDevice(013, dk8ea);
         auto s0 = dk8ea->getClockFlag();
-        std::this_thread::sleep_for(20ms);
+        pdp8->scheduler.runDue(DK8_EA::TickCycles - 1);
         auto s1 = dk8ea->getClockFlag();
-        ct::expect(ct::lift(!s0) and ct::lift(s1));
+        pdp8->scheduler.runDue(DK8_EA::TickCycles);
+        auto s2 = dk8ea->getClockFlag();
+        ct::expect(ct::lift(!s0) and ct::lift(!s1) and ct::lift(s2)
+                   and ct::lift(pdp8->scheduler.nextDeadline() == 2 * DK8_EA::TickCycles));
     };
 }};
 
@@ -528,8 +554,1173 @@ auto const suite11 = ct::Suite { "Multiplier", [] {
 auto const suite12 = ct::Suite { "Inst Cycle", [] {
     "DK8_E"_test = [] { TestProgram t("OCTAL\n*0200\nCLSK\nJMP 0200\nHLT\n*0200",
           [](TestProgram& t){
-              t.pdp8.iotDevices[013] = std::make_shared<DK8_EA>();
+              t.pdp8.attachDevice(013, std::make_shared<DK8_EA>());
     });
         ct::expect(t.pass1 and ct::lift(t.pass2));
     };
-}};
\ No newline at end of file
+}};
+struct BatchAssembly {
+    PDP8 pdp8{};
+    bool loaded{false};
+
+    template<typename Str>
+    requires StringLike<Str>
+    explicit BatchAssembly(Str s, PDP8::ExecutionEngine engine = PDP8::ExecutionEngine::Switch) : pdp8(engine) {
+        std::stringstream testCode{std::string(s)};
+        Assembler assembler{};
+        assembler.readProgram(testCode);
+        std::stringstream bin{};
+        std::stringstream list{};
+        loaded = assembler.pass1() && assembler.pass2(bin, list) && pdp8.readBinaryFormat(bin);
+    }
+};
+
+struct CountingDevice : public IOTDevice {
+    unsigned operations{0};
+    unsigned handled{0};
+
+    void operation(PDP8 &, unsigned int, unsigned int) override { ++operations; }
+    bool getInterruptRequest(unsigned long) override { return false; }
+    bool getServiceRequest(unsigned long) override { return false; }
+    void setServiceRequest(unsigned long) override {}
+
+    void registerOperations(unsigned long, IotOperations &ops) override {
+        ops[1] = IotHandler{[](void *context, PDP8 &) { ++static_cast<CountingDevice *>(context)->handled; }, this};
+    }
+};
+
+auto const suite13 = ct::Suite { "Batch Run", [] {
+    "Halt"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nCLA CLL CMA IAC\nHLT\n*0200\n"};
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt)
+                   and t.pdp8.memory.programCounter.getProgramCounter() == 0202_i
+                   and t.pdp8.accumulator.getLink() == 1_i);
+    };
+    "Budget"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, IAC\nNOP\nJMP Loop\n*0200\n"};
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(30);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::BudgetExhausted)
+                   and t.pdp8.accumulator.getAcc() == 10_i and ct::lift(t.pdp8.get_run_flag()));
+    };
+    "Stopped"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nIAC\nHLT\n*0200\n"};
+        auto exit = t.pdp8.run(10);
+        ct::expect(ct::lift(exit == PDP8::RunExit::Halt) and t.pdp8.accumulator.getAcc() == 0_i);
+    };
+    "Deadline"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, IAC\nNOP\nJMP Loop\n*0200\n"};
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.runUntil(std::chrono::steady_clock::now() + 2ms);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::BudgetExhausted));
+    };
+    "Step"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nIAC\nIAC\nHLT\n*0200\n"};
+        auto exit = t.pdp8.step();
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::BudgetExhausted)
+                   and t.pdp8.accumulator.getAcc() == 1_i and ct::lift(!t.pdp8.get_run_flag()));
+    };
+    "Step HLT"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nHLT\n*0200\n"};
+        ct::expect(t.loaded and ct::lift(t.pdp8.step() == PDP8::RunExit::Halt));
+    };
+    "Partial"_test = [] {
+        BatchAssembly t{"OCTAL\n*0177\n0202\nTAD I 0177\nHLT\n0017\n*0200\n"};
+        t.pdp8.set_step_flag(true);
+        while (t.pdp8.get_step_flag())
+            t.pdp8.instructionStep();       // Interrupt and Fetch cycles
+        auto exit = t.pdp8.step();          // Complete Defer and Execute
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::BudgetExhausted)
+                   and ct::lift(t.pdp8.cycle_state == PDP8::CycleState::Interrupt)
+                   and t.pdp8.accumulator.getAcc() == 017_i
+                   and t.pdp8.memory.programCounter.getProgramCounter() == 0201_i);
+    };
+    "Busy JMP .-1"_test = [] {
+        BatchAssembly t{"OCTAL\n*0177\n07776\nLoop, ISZ 0177\nJMP Loop\nHLT\n*0200\n"};
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt) and ct::lift(!t.pdp8.idle_flag));
+    };
+    "Idle"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, CLSK\nJMP Loop\nHLT\n*0200\n"};
+        t.pdp8.attachDevice(013, std::make_shared<DK8_EA>(false));
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::IdleWait) and ct::lift(t.pdp8.idle_flag));
+    };
+    "IOT Dispatch"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\n6571\n6572\n6561\nHLT\n*0200\n"};
+        auto device = std::make_shared<CountingDevice>();
+        t.pdp8.attachDevice(057, device);
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt)
+                   and device->handled == 1_i and device->operations == 1_i);
+    };
+    "Busy Tick"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, IAC\nCLSK\nJMP Loop\nHLT\n*0200\n"};
+        t.pdp8.attachDevice(013, std::make_shared<DK8_EA>());
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(2 * DK8_EA::TickCycles);
+        auto cycles = t.pdp8.getCycleCount();
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt)
+                   and ct::lift(cycles >= DK8_EA::TickCycles and cycles <= DK8_EA::TickCycles + 4));
+    };
+    "Idle Tick"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, CLSK\nJMP Loop\nHLT\n*0200\n"};
+        t.pdp8.attachDevice(013, std::make_shared<DK8_EA>());
+        t.pdp8.set_run_flag(true);
+        auto idle = t.pdp8.run(100);
+        auto wait = t.pdp8.idleAdvance();
+        auto exit = t.pdp8.run(100);
+        ct::expect(t.loaded and ct::lift(idle == PDP8::RunExit::IdleWait)
+                   and ct::lift(wait == std::chrono::steady_clock::duration::zero())
+                   and ct::lift(exit == PDP8::RunExit::Halt)
+                   and ct::lift(t.pdp8.getCycleCount() >= DK8_EA::TickCycles)
+                   and ct::lift(t.pdp8.getInstructionCount() < 100));
+    };
+    "Real Time"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, CLSK\nJMP Loop\nHLT\n*0200\n"};
+        t.pdp8.attachDevice(013, std::make_shared<DK8_EA>());
+        t.pdp8.setTimingMode(PDP8::TimingMode::RealTime);
+        t.pdp8.set_run_flag(true);
+        auto start = std::chrono::steady_clock::now();
+        auto exit = t.pdp8.run(100);
+        while (exit == PDP8::RunExit::IdleWait) {
+            auto ticket = t.pdp8.idleWakeup->ticket();
+            if (auto wait = t.pdp8.idleAdvance(); wait > std::chrono::steady_clock::duration::zero())
+                t.pdp8.idleWakeup->waitFor(ticket, wait);
+            exit = t.pdp8.run(100);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt) and ct::lift(elapsed >= 7ms));
+    };
+    "Printer Event"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nCLA\nTAD 0210\nTLS\nTSF\nJMP .-1\nHLT\n*0210\n0101\n*0200\n"};
+        std::stringstream input{}, output{};
+        auto decWriter = std::make_shared<DECWriter>();
+        decWriter->attachStreams(input, output);
+        t.pdp8.attachDevice(decWriter->keyboardDevice, decWriter);
+        t.pdp8.attachDevice(decWriter->printerDevice, decWriter);
+        t.pdp8.set_run_flag(true);
+        auto idle = t.pdp8.run(100);
+        auto busy = !decWriter->getServiceRequest(decWriter->printerDevice);
+        auto wait = t.pdp8.idleAdvance();
+        auto exit = t.pdp8.run(100);
+        ct::expect(t.loaded and ct::lift(idle == PDP8::RunExit::IdleWait) and ct::lift(busy)
+                   and ct::lift(wait == std::chrono::steady_clock::duration::zero())
+                   and ct::lift(exit == PDP8::RunExit::Halt) and ct::lift(output.str() == "A")
+                   and ct::lift(t.pdp8.getCycleCount() >= decWriter->printCycles));
+    };
+    "Print Rate"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nCLA\nTAD 0210\nTLS\nTSF\nJMP .-1\nHLT\n*0210\n0101\n*0200\n"};
+        std::stringstream input{}, output{};
+        auto decWriter = std::make_shared<DECWriter>();
+        decWriter->attachStreams(input, output);
+        decWriter->setPrintRate(0);
+        t.pdp8.attachDevice(decWriter->keyboardDevice, decWriter);
+        t.pdp8.attachDevice(decWriter->printerDevice, decWriter);
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        auto clone = std::dynamic_pointer_cast<DECWriter>(decWriter->clone());
+        decWriter->setPrintRate(10);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt) and ct::lift(output.str() == "A")
+                   and clone->getPrintRate() == 0_i and decWriter->getPrintRate() == 10_i
+                   and ct::lift(decWriter->printCycles == EventScheduler::cycles(std::chrono::milliseconds{100})));
+    };
+    "Wakeup"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, CLSK\nJMP Loop\nHLT\n*0200\n"};
+        auto dk8ea = std::make_shared<DK8_EA>(false);
+        t.pdp8.attachDevice(013, dk8ea);
+        t.pdp8.set_run_flag(true);
+        auto ticket = t.pdp8.idleWakeup->ticket();
+        auto exit = t.pdp8.run(100);
+        std::jthread clock{[dk8ea]() {
+            std::this_thread::sleep_for(5ms);
+            dk8ea->setServiceRequest(013);
+        }};
+        auto woken = t.pdp8.idleWakeup->waitFor(ticket, 1s);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::IdleWait) and ct::lift(woken)
+                   and ct::lift(t.pdp8.run(100) == PDP8::RunExit::Halt) and ct::lift(!dk8ea->getClockFlag()));
+    };
+}};
+
+auto const suite14 = ct::Suite { "Predecode", [] {
+    "Direct"_test = [] {
+        DecodedInstruction d{01350u, 02345u};   // TAD 0150 on the current page
+        ct::expect(ct::lift(d.mode == AddressMode::Direct) and ct::lift(d.opCode == OpCode::TAD) and d.address == 02350_i);
+    };
+    "Zero Page"_test = [] {
+        DecodedInstruction d{03150u, 02345u};   // DCA 0150 on page 0
+        ct::expect(ct::lift(d.mode == AddressMode::Direct) and d.address == 0150_i);
+    };
+    "Indirect"_test = [] {
+        DecodedInstruction d{05750u, 02345u};   // JMP I 0150 on the current page
+        ct::expect(ct::lift(d.mode == AddressMode::Indirect) and d.address == 02350_i);
+    };
+    "Auto Index"_test = [] {
+        DecodedInstruction d{01410u, 02345u};   // TAD I 010
+        ct::expect(ct::lift(d.mode == AddressMode::AutoIndex) and d.address == 010_i);
+    };
+    "OPR"_test = [] {
+        DecodedInstruction d{07201u, 02345u};
+        ct::expect(ct::lift(d.mode == AddressMode::None) and ct::lift(d.opCode == OpCode::OPR));
+    };
+    "Self Modify"_test = [] {
+        BatchAssembly t{R"(
+                OCTAL
+*0177
+Count,          07776
+*0200
+Loop,           CLA IAC
+                ISZ Count
+                JMP Mod
+                HLT
+Mod,            CLA
+                TAD NewOp
+                DCA Loop
+                JMP Loop
+NewOp,          7240
+*0200
+)"};
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt) and t.pdp8.accumulator.getAcc() == 07777_i);
+    };
+}};
+
+auto const suite15 = ct::Suite { "OPR Table", [] {
+    "Equivalence"_test = [] {
+        static constexpr std::array<std::array<unsigned, 4>, 6> states{{
+            {0u, 0u, 0u, 0u}, {07777u, 1u, 07777u, 07777u}, {04000u, 0u, 01234u, 05252u},
+            {03777u, 1u, 0u, 02525u}, {00001u, 0u, 07070u, 0u}, {06543u, 1u, 00707u, 01111u}}};
+        auto reference = std::make_unique<PDP8>();
+        auto table = std::make_unique<PDP8>();
+        unsigned mismatches = 0;
+        for (unsigned bits = 0; bits < 512; ++bits) {
+            for (auto const &state: states) {
+                std::array<bool, 2> threw{};
+                for (auto idx = 0u; idx < 2u; ++idx) {
+                    auto &cpu = idx ? *table : *reference;
+                    cpu.accumulator.setAcc(state[0]);
+                    cpu.accumulator.setLink(state[1]);
+                    cpu.mulQuotient.setWord(state[2]);
+                    cpu.opSxReg.value = static_cast<uint16_t>(state[3]);
+                    cpu.memory.programCounter.setProgramCounter(0200u);
+                    cpu.set_run_flag(true);
+                    cpu.instructionReg.value = static_cast<uint16_t>(07000u | bits);
+                    try {
+                        if (idx)
+                            cpu.execute();
+                        else
+                            cpu.execute_opr();
+                    } catch (std::logic_error &) {
+                        threw[idx] = true;
+                    }
+                }
+                if (threw[0] != threw[1]
+                    || reference->accumulator.getArithmetic() != table->accumulator.getArithmetic()
+                    || reference->mulQuotient.getWord() != table->mulQuotient.getWord()
+                    || reference->memory.programCounter.getProgramCounter() != table->memory.programCounter.getProgramCounter()
+                    || reference->get_run_flag() != table->get_run_flag())
+                    ++mismatches;
+            }
+        }
+        ct::expect(mismatches == 0_i);
+    };
+}};
+
+static constexpr std::array<std::string_view, 3> EnginePrograms{{
+    // Sum a table through an auto index register.
+    R"(
+                OCTAL
+*0010
+Ptr,            Table-1
+*0200
+                CLA CLL
+                TAD Len
+                DCA Cnt
+Loop,           TAD I Ptr
+                ISZ Cnt
+                JMP Loop
+                DCA Sum
+                HLT
+Len,            7773
+Cnt,            0
+Sum,            0
+Table,          1
+                2
+                3
+                4
+                5
+*0200
+)",
+    // Subroutine calls with an indirect return and indirect data.
+    R"(
+                OCTAL
+*0200
+                CLA
+                JMS Sub
+                JMS Sub
+                JMS Sub
+                DCA Out
+                HLT
+Sub,            0
+                TAD I Pval
+                RAL
+                JMP I Sub
+Pval,           Val
+Val,            3
+Out,            0
+*0200
+)",
+    // Group 3 and skip microinstructions.
+    R"(
+                OCTAL
+*0200
+                CLA CLL CMA
+                MQL
+                TAD K17
+                SWP
+                SZA
+                CMA
+                SMA SZA
+                IAC
+                SNL
+                CML
+                DCA Out
+                MQA
+                AND K17
+                HLT
+K17,            17
+Out,            0
+*0200
+)"}};
+
+/**
+ * @brief Run each of the EnginePrograms on the switch engine and another engine and count differences.
+ */
+static unsigned engineMismatches(PDP8::ExecutionEngine engine) {
+    unsigned mismatches = 0;
+    for (auto program: EnginePrograms) {
+        BatchAssembly reference{program};
+        BatchAssembly other{program, engine};
+        reference.pdp8.set_run_flag(true);
+        other.pdp8.set_run_flag(true);
+        auto referenceExit = reference.pdp8.run(1000);
+        auto otherExit = other.pdp8.run(1000);
+        if (!reference.loaded || !other.loaded || referenceExit != PDP8::RunExit::Halt || referenceExit != otherExit
+            || reference.pdp8.accumulator.getArithmetic() != other.pdp8.accumulator.getArithmetic()
+            || reference.pdp8.mulQuotient.getWord() != other.pdp8.mulQuotient.getWord()
+            || reference.pdp8.memory.programCounter.getProgramCounter() !=
+               other.pdp8.memory.programCounter.getProgramCounter())
+            ++mismatches;
+        for (Memory::base_type address = 0; address < 010000u; ++address)
+            if (reference.pdp8.memory.read(0, address).getData() != other.pdp8.memory.read(0, address).getData())
+                ++mismatches;
+    }
+    return mismatches;
+}
+
+auto const suite16 = ct::Suite { "Threaded Engine", [] {
+    "Equivalence"_test = [] {
+        ct::expect(engineMismatches(PDP8::ExecutionEngine::Threaded) == 0_i);
+    };
+    "Budget"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, IAC\nNOP\nJMP Loop\n*0200\n", PDP8::ExecutionEngine::Threaded};
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(30);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::BudgetExhausted)
+                   and t.pdp8.accumulator.getAcc() == 10_i);
+    };
+    "Step"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nIAC\nIAC\nHLT\n*0200\n", PDP8::ExecutionEngine::Threaded};
+        t.pdp8.step();
+        ct::expect(t.loaded and t.pdp8.accumulator.getAcc() == 1_i
+                   and t.pdp8.memory.programCounter.getProgramCounter() == 0201_i);
+    };
+}};
+
+auto const suite17 = ct::Suite { "Block Cache", [] {
+    "Equivalence"_test = [] {
+        ct::expect(engineMismatches(PDP8::ExecutionEngine::Block) == 0_i);
+    };
+    "Self Modify"_test = [] {
+        BatchAssembly t{R"(
+                OCTAL
+*0177
+Count,          07776
+*0200
+Loop,           CLA IAC
+                ISZ Count
+                JMP Mod
+                HLT
+Mod,            CLA
+                TAD NewOp
+                DCA Loop
+                JMP Loop
+NewOp,          7240
+*0200
+)", PDP8::ExecutionEngine::Block};
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt) and t.pdp8.accumulator.getAcc() == 07777_i);
+    };
+    "Modify Ahead"_test = [] {
+        BatchAssembly t{R"(
+                OCTAL
+*0200
+                CLA
+                TAD NewOp
+                DCA Patch
+                NOP
+Patch,          IAC
+                HLT
+NewOp,          7240
+*0200
+)", PDP8::ExecutionEngine::Block};
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt) and t.pdp8.accumulator.getAcc() == 07777_i);
+    };
+    "Registers"_test = [] {
+        // Straight line code with indirect and auto index references, run from the translation up to the HLT.
+        static constexpr std::string_view Program = R"(
+                OCTAL
+*0010
+Index,          Table-1
+*0200
+                CLA CLL
+                TAD I Index
+                TAD I Index
+                DCA Sum
+                TAD I Pointer
+                RAL
+                DCA I Pointer
+                TAD Sum
+                HLT
+Pointer,        Sum
+Sum,            0
+Table,          0123
+                0456
+*0200
+)";
+        BatchAssembly reference{Program};
+        BatchAssembly block{Program, PDP8::ExecutionEngine::Block};
+        reference.pdp8.set_run_flag(true);
+        block.pdp8.set_run_flag(true);
+        auto referenceExit = reference.pdp8.run(100);
+        auto blockExit = block.pdp8.run(100);
+        ct::expect(reference.loaded and block.loaded and ct::lift(blockExit == referenceExit)
+                   and ct::lift(block.pdp8.accumulator.getArithmetic() == reference.pdp8.accumulator.getArithmetic())
+                   and ct::lift(block.pdp8.memory.programCounter.getProgramCounter() ==
+                                reference.pdp8.memory.programCounter.getProgramCounter())
+                   and ct::lift(block.pdp8.memory.memoryAddress.value == reference.pdp8.memory.memoryAddress.value)
+                   and ct::lift(block.pdp8.memory.memoryBuffer.getData() ==
+                                reference.pdp8.memory.memoryBuffer.getData())
+                   and ct::lift(block.pdp8.instructionReg.getWord() == reference.pdp8.instructionReg.getWord())
+                   and ct::lift(block.pdp8.getInstructionCount() == reference.pdp8.getInstructionCount())
+                   and block.pdp8.memory.read(0, 0212).getData() == 01402_i);
+    };
+    "Step"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nIAC\nIAC\nHLT\n*0200\n", PDP8::ExecutionEngine::Block};
+        t.pdp8.step();
+        ct::expect(t.loaded and t.pdp8.accumulator.getAcc() == 1_i
+                   and t.pdp8.memory.programCounter.getProgramCounter() == 0201_i);
+    };
+}};
+
+auto const suite18 = ct::Suite { "Profiler", [] {
+    "Counts"_test = [] {
+        BatchAssembly t{EnginePrograms[0]};
+        auto &profiler = t.pdp8.enableProfiler();
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(1000);
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt)
+                   and ct::lift(profiler.getInstructions()) == 19_i
+                   and ct::lift(profiler.getCount(0203)) == 5_i
+                   and ct::lift(profiler.getOpCodeCount(static_cast<unsigned>(OpCode::TAD))) == 6_i
+                   and ct::lift(profiler.getOperateCount(0300)) == 1_i
+                   and ct::lift(profiler.getAutoIndexes()) == 5_i);
+    };
+    "CSV"_test = [] {
+        BatchAssembly t{EnginePrograms[0], PDP8::ExecutionEngine::Threaded};
+        t.pdp8.enableProfiler();
+        t.pdp8.set_run_flag(true);
+        t.pdp8.run(1000);
+        auto profile = t.pdp8.disableProfiler();
+        std::stringstream csv{};
+        profile->writeCsv(csv);
+        ct::expect(ct::lift(csv.str().find("location,00203,5\n") != std::string::npos)
+                   and ct::lift(t.pdp8.getProfiler() == nullptr));
+    };
+}};
+
+auto const suite19 = ct::Suite { "Panel Renderer", [] {
+    "Diff"_test = [] {
+        auto lampsDrawn = [](const std::string &frame) {
+            std::size_t count = 0;
+            for (auto pos = frame.find(TerminalConsts::Light[0]); pos != std::string::npos;
+                 pos = frame.find(TerminalConsts::Light[0], pos + 1))
+                ++count;
+            for (auto pos = frame.find(TerminalConsts::Light[1]); pos != std::string::npos;
+                 pos = frame.find(TerminalConsts::Light[1], pos + 1))
+                ++count;
+            return count;
+        };
+        PanelRenderer renderer{};
+        PanelSnapshot panel{};
+        auto first = lampsDrawn(renderer.render(panel, "status"));
+        auto unchanged = renderer.render(panel, "status").empty();
+        panel.programCounter = 0200u;
+        auto changed = lampsDrawn(renderer.render(panel, "status"));
+        renderer.invalidate();
+        auto redrawn = lampsDrawn(renderer.render(panel, "status"));
+        ct::expect(ct::lift(first == renderer.lampCount()) and ct::lift(unchanged)
+                   and changed == 1_i and ct::lift(redrawn == renderer.lampCount()));
+    };
+    "Rate"_test = [] {
+        PanelRenderer renderer{30.0};
+        auto now = PanelRenderer::clock::now();
+        renderer.render(PanelSnapshot{}, "", now);
+        ct::expect(ct::lift(!renderer.frameDue(now + 10ms)) and ct::lift(renderer.frameDue(now + 40ms)));
+    };
+}};
+
+auto const suite20 = ct::Suite { "Lamp Intensity", [] {
+    "Duty Cycle"_test = [] {
+        LampAccumulator lamps{};
+        LampAccumulator::Sample sample{};
+        for (unsigned idx = 0; idx < 1000u; ++idx) {
+            sample.programCounter = idx & 1u ? 07777u : 0u;
+            sample.run = idx < 250u;
+            lamps.add(sample);
+        }
+        LampAccumulator::Intensities intensities{};
+        auto harvested = lamps.harvest(intensities);
+        // PC bit 11 is lamp 6, PC bit 0 is lamp 17, Fetch is lamp 80 and Run is lamp 85.
+        ct::expect(ct::lift(harvested) and intensities[6] == 128_i and intensities[17] == 128_i
+                   and intensities[80] == 255_i and intensities[85] == 64_i and intensities[0] == 0_i
+                   and ct::lift(!lamps.harvest(intensities)));
+    };
+    "CPU"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, IAC\nNOP\nJMP Loop\n*0200\n", PDP8::ExecutionEngine::Threaded};
+        t.pdp8.enableLampAccumulator(true);
+        t.pdp8.set_run_flag(true);
+        t.pdp8.run(300);
+        LampAccumulator::Intensities intensities{};
+        auto harvested = t.pdp8.harvestLamps(intensities);
+        // JMP is lamp 77, OPR lamp 79 and Defer lamp 82.
+        ct::expect(ct::lift(harvested) and intensities[79] == 170_i and intensities[77] == 85_i
+                   and intensities[82] == 0_i);
+    };
+}};
+
+auto const suite21 = ct::Suite{"Terminal Manager", [] {
+    "Post"_test = [] {
+        TerminalManager manager{};
+        manager.post();
+        manager.post();
+        auto start = std::chrono::steady_clock::now();
+        manager.serviceTerminals();
+        ct::expect(ct::lift(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100)));
+    };
+    "Post From Thread"_test = [] {
+        TerminalManager manager{};
+        std::jthread poster{[&manager] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            manager.post();
+        }};
+        auto start = std::chrono::steady_clock::now();
+        manager.serviceTerminals();
+        ct::expect(ct::lift(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20)));
+    };
+}};
+
+auto const suite22 = ct::Suite{"Ring Buffer", [] {
+    "Wrap"_test = [] {
+        RingBuffer<char, 8> ring{};
+        std::array<char, 8> out{};
+        unsigned pushed = 0;
+        while (ring.push(static_cast<char>('a' + pushed)))
+            ++pushed;
+        auto first = ring.pop(std::span(out.data(), 5));
+        ct::expect(pushed == 8_i and first == 5_i and out[0] == 'a' and out[4] == 'e');
+        for (char c: {'x', 'y', 'z'})
+            ring.push(c);
+        auto second = ring.pop(out);
+        ct::expect(second == 6_i and out[0] == 'f' and out[5] == 'z' and ct::lift(ring.empty()));
+    };
+    "Threads"_test = [] {
+        RingBuffer<unsigned, 64> ring{};
+        static constexpr unsigned Count = 100000;
+        std::jthread producer{[&ring] {
+            for (unsigned value = 0; value < Count;)
+                if (ring.push(value))
+                    ++value;
+        }};
+        std::array<unsigned, 16> out{};
+        unsigned expected = 0, errors = 0;
+        while (expected < Count) {
+            auto count = ring.pop(out);
+            for (std::size_t idx = 0; idx < count; ++idx)
+                errors += out[idx] != expected++;
+        }
+        ct::expect(errors == 0_i);
+    };
+    "Instruction Count"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nLoop, IAC\nJMP Loop\n*0200\n"};
+        t.pdp8.set_run_flag(true);
+        t.pdp8.run(100);
+        ct::expect(t.pdp8.getInstructionCount() == 100_i);
+    };
+}};
+
+auto const suite23 = ct::Suite{"Headless", [] {
+    "Arguments"_test = [] {
+        std::array<const char *, 8> arguments{"--bin", "prog.bin", "--start", "10200", "--budget", "1000",
+                                              "--print-rate", "0"};
+        auto options = HeadlessRunner::parseArguments(std::span(const_cast<char *const *>(arguments.data()), arguments.size()));
+        std::array<const char *, 2> neither{"--budget", "1000"};
+        bool rejected = false;
+        try {
+            HeadlessRunner::parseArguments(std::span(const_cast<char *const *>(neither.data()), neither.size()));
+        } catch (const std::invalid_argument &) {
+            rejected = true;
+        }
+        ct::expect(options.binFile == "prog.bin" and options.start.value_or(0) == 010200_i
+                   and options.budget == 1000_i and options.printRate == 0_i and ct::lift(rejected));
+    };
+    "Echo"_test = [] {
+        auto directory = std::filesystem::temp_directory_path();
+        auto source = directory / "pdp8-headless-echo.pal";
+        auto input = directory / "pdp8-headless-echo.in";
+        auto output = directory / "pdp8-headless-echo.out";
+        std::ofstream{source} << "OCTAL\n*0200\nStart, CLA CLL\nLoop, KSF\nJMP .-1\nKRB\nTLS\nTSF\nJMP .-1\n"
+                                 "TAD MPer\nSZA CLA\nJMP Loop\nHLT\nMPer, 7722\n*Start\n";
+        std::ofstream{input} << "PDP-8.IGNORED";
+
+        HeadlessOptions options{};
+        options.palFile = source.string();
+        options.inputFile = input.string();
+        options.outputFile = output.string();
+        HeadlessRunner::StopReason stopReason;
+        {
+            HeadlessRunner runner{options};
+            runner.load();
+            stopReason = runner.run();
+        }
+        std::stringstream printed{};
+        printed << std::ifstream{output}.rdbuf();
+        std::filesystem::remove(source);
+        std::filesystem::remove(input);
+        std::filesystem::remove(output);
+        ct::expect(ct::lift(stopReason == HeadlessRunner::StopReason::Halt) and printed.str() == "PDP-8.");
+    };
+}};
+
+auto const suite24 = ct::Suite{"DK8-EP", [] {
+    "Registers"_test = [] {
+        auto pdp8 = std::make_unique<PDP8>();
+        auto dk8ep = std::make_shared<DK8_EP>();
+        pdp8->attachDevice(013, dk8ep);
+        pdp8->accumulator.setAcc(01234);
+        dk8ep->operation(*pdp8, 013, 3);        // CLAB
+        pdp8->accumulator.setAcc(05000);
+        dk8ep->operation(*pdp8, 013, 2);        // CLDE
+        pdp8->accumulator.setAcc(01000);
+        dk8ep->operation(*pdp8, 013, 0);        // CLZE
+        dk8ep->operation(*pdp8, 013, 4);        // CLEN
+        auto enable = pdp8->accumulator.getAcc();
+        dk8ep->operation(*pdp8, 013, 6);        // CLBA
+        auto buffer = pdp8->accumulator.getAcc();
+        dk8ep->operation(*pdp8, 013, 7);        // CLCA, the counter is stopped
+        auto counter = pdp8->accumulator.getAcc();
+        ct::expect(enable == 04000_i and buffer == 01234_i and counter == 01234_i
+                   and ct::lift(pdp8->scheduler.empty()));
+    };
+    "Counter"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nCLA\nTAD 0220\nCLDE\nCLA\nNOP\nNOP\nNOP\nCLCA\nHLT\n*0220\n0600\n*0200\n"};
+        t.pdp8.attachDevice(013, std::make_shared<DK8_EP>());
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        // Five instructions of 1.5 us, CLA to CLCA, at 1 MHz.
+        ct::expect(t.loaded and ct::lift(exit == PDP8::RunExit::Halt) and t.pdp8.accumulator.getAcc() == 7_i);
+    };
+    "Overflow"_test = [] {
+        BatchAssembly t{"OCTAL\n*0200\nCLA\nTAD 0220\nCLAB\nCLA\nTAD 0221\nCLDE\n6131\nJMP .-1\nCLSA\nHLT\n"
+                        "*0220\n7766\n1400\n*0200\n"};
+        auto dk8ep = std::make_shared<DK8_EP>();
+        t.pdp8.attachDevice(013, dk8ep);
+        t.pdp8.set_run_flag(true);
+        auto idle = t.pdp8.run(100);
+        auto wait = t.pdp8.idleAdvance();
+        auto exit = t.pdp8.run(100);
+        // Ten counts at 10 kHz from the CLDE, 6 instructions in.
+        auto cycles = t.pdp8.getCycleCount();
+        ct::expect(t.loaded and ct::lift(idle == PDP8::RunExit::IdleWait)
+                   and ct::lift(wait == std::chrono::steady_clock::duration::zero())
+                   and ct::lift(exit == PDP8::RunExit::Halt)
+                   and t.pdp8.accumulator.getAcc() == 04000_i and ct::lift(dk8ep->getStatus() == 0)
+                   and ct::lift(cycles >= 6 + 667 and cycles <= 6 + 670)
+                   and ct::lift(t.pdp8.scheduler.nextDeadline() == 6 + 2 * 667));
+    };
+    "Interrupt"_test = [] {
+        auto pdp8 = std::make_unique<PDP8>();
+        auto dk8ep = std::make_shared<DK8_EP>();
+        pdp8->attachDevice(013, dk8ep);
+        dk8ep->setServiceRequest(013);
+        auto disabled = pdp8->interruptRequests->pending();
+        pdp8->accumulator.setAcc(DK8_EP::InterruptEnable);
+        dk8ep->operation(*pdp8, 013, 2);        // CLDE
+        auto enabled = pdp8->interruptRequests->test(013);
+        dk8ep->operation(*pdp8, 013, 5);        // CLSA
+        ct::expect(ct::lift(!disabled) and ct::lift(enabled) and ct::lift(!pdp8->interruptRequests->pending())
+                   and pdp8->accumulator.getAcc() == 04000_i);
+    };
+}};
+
+namespace {
+    /**
+     * @brief Run a PDP8 until it halts, letting emulated time pass while it idles.
+     */
+    PDP8::RunExit runToHalt(PDP8 &pdp8) {
+        auto exit = pdp8.run(1000);
+        for (int batch = 0; batch < 1000 && exit != PDP8::RunExit::Halt; ++batch) {
+            if (exit == PDP8::RunExit::IdleWait)
+                pdp8.idleAdvance();
+            exit = pdp8.run(1000);
+        }
+        return exit;
+    }
+
+    /**
+     * @brief A PDP8 with a DECWriter and DK8-EA attached.
+     */
+    struct SnapshotMachine {
+        PDP8 pdp8{};
+        std::stringstream input{}, output{};
+        std::shared_ptr<DECWriter> decWriter{std::make_shared<DECWriter>()};
+
+        SnapshotMachine() {
+            decWriter->attachStreams(input, output);
+            pdp8.attachDevice(decWriter->keyboardDevice, decWriter);
+            pdp8.attachDevice(decWriter->printerDevice, decWriter);
+            pdp8.attachDevice(013, std::make_shared<DK8_EA>());
+        }
+    };
+}
+
+auto const suite25 = ct::Suite{"Snapshot", [] {
+    "Round Trip"_test = [] {
+        // Print a character, wait for a clock tick, then for the printer.
+        BatchAssembly t{"OCTAL\n*0200\nCLA\nTAD 0220\nTLS\nCLSK\nJMP .-1\nTSF\nJMP .-1\nHLT\n*0220\n0101\n*0200\n"};
+        SnapshotMachine first{};
+        for (std::size_t location = 0200; location < 0221; ++location)
+            first.pdp8.memory.write(0, static_cast<Memory::base_type>(location),
+                                    t.pdp8.memory.peek(location) & 07777u, true);
+        first.pdp8.set_run_flag(true);
+        first.pdp8.run(3);
+
+        std::stringstream snapshot{};
+        first.pdp8.saveSnapshot(snapshot);
+        auto firstExit = runToHalt(first.pdp8);
+
+        SnapshotMachine second{};
+        second.pdp8.restoreSnapshot(snapshot);
+        auto secondExit = runToHalt(second.pdp8);
+
+        bool sameCore = true;
+        for (std::size_t location = 0; location < 010000; ++location)
+            sameCore = sameCore && first.pdp8.memory.peek(location) == second.pdp8.memory.peek(location);
+        ct::expect(t.loaded and ct::lift(firstExit == PDP8::RunExit::Halt)
+                   and ct::lift(secondExit == PDP8::RunExit::Halt) and ct::lift(sameCore)
+                   and ct::lift(first.output.str() == "A") and ct::lift(second.output.str().empty())
+                   and ct::lift(second.pdp8.getCycleCount() == first.pdp8.getCycleCount())
+                   and ct::lift(second.pdp8.getCycleCount() >= first.decWriter->printCycles)
+                   and second.pdp8.memory.programCounter.getProgramCounter() == 0210_i
+                   and second.pdp8.accumulator.getAcc() == 0101_i);
+    };
+    "Damaged"_test = [] {
+        auto rejected = [](const std::string &bytes, PDP8 &pdp8) {
+            std::istringstream snapshot{bytes};
+            try {
+                pdp8.restoreSnapshot(snapshot);
+            } catch (const SnapshotError &) {
+                return true;
+            }
+            return false;
+        };
+        SnapshotMachine machine{};
+        std::stringstream snapshot{};
+        machine.pdp8.saveSnapshot(snapshot);
+        auto good = snapshot.str();
+        PDP8 bare{};
+        ct::expect(ct::lift(rejected("garbage", machine.pdp8))
+                   and ct::lift(rejected(good.substr(0, good.size() / 2), machine.pdp8))
+                   and ct::lift(rejected(good, bare)) and ct::lift(!rejected(good, machine.pdp8)));
+    };
+    "Arguments"_test = [] {
+        std::array<const char *, 4> restore{"--snapshot", "booted.snap", "--save-snapshot", "after.snap"};
+        auto options = HeadlessRunner::parseArguments(std::span(const_cast<char *const *>(restore.data()), restore.size()));
+        std::array<const char *, 4> both{"--pal", "prog.pal", "--snapshot", "booted.snap"};
+        bool rejected = false;
+        try {
+            HeadlessRunner::parseArguments(std::span(const_cast<char *const *>(both.data()), both.size()));
+        } catch (const std::invalid_argument &) {
+            rejected = true;
+        }
+        ct::expect(options.snapshotFile == "booted.snap" and options.saveSnapshotFile == "after.snap"
+                   and ct::lift(rejected));
+    };
+}};
+
+auto const suite26 = ct::Suite{"Fork", [] {
+    "Copy On Write"_test = [] {
+        SnapshotMachine parent{};
+        parent.pdp8.memory.write(0, 0100, 01234, true);
+        parent.pdp8.memory.write(1, 0100, 04321, true);
+        parent.pdp8.accumulator.setAcc(0777);
+        auto child = parent.pdp8.fork();
+        auto sharedAfterFork = child->memory.privatePages() == 0 && parent.pdp8.memory.privatePages() == 0;
+
+        child->memory.write(0, 0100, 07070, true);
+        parent.pdp8.memory.write(0, 0101, 05555, true);
+        ct::expect(ct::lift(sharedAfterFork) and child->memory.privatePages() == 1_i
+                   and parent.pdp8.memory.privatePages() == 1_i
+                   and (child->memory.peek(0100) & 07777u) == 07070_i
+                   and (parent.pdp8.memory.peek(0100) & 07777u) == 01234_i
+                   and (child->memory.peek(0101) & 07777u) == 0_i
+                   and (child->memory.peek(010100) & 07777u) == 04321_i
+                   and child->accumulator.getAcc() == 0777_i);
+    };
+    "Devices"_test = [] {
+        // Print a character, wait for a clock tick, then for the printer.
+        BatchAssembly t{"OCTAL\n*0200\nCLA\nTAD 0220\nTLS\nCLSK\nJMP .-1\nTSF\nJMP .-1\nHLT\n*0220\n0101\n*0200\n"};
+        SnapshotMachine parent{};
+        for (std::size_t location = 0200; location < 0221; ++location)
+            parent.pdp8.memory.write(0, static_cast<Memory::base_type>(location),
+                                     t.pdp8.memory.peek(location) & 07777u, true);
+        parent.pdp8.set_run_flag(true);
+        parent.pdp8.run(3);
+
+        auto child = parent.pdp8.fork();
+        std::stringstream input{}, output{};
+        auto decWriter = std::dynamic_pointer_cast<DECWriter>(child->iotDevices.at(3));
+        decWriter->attachStreams(input, output);
+        auto parentExit = runToHalt(parent.pdp8);
+        auto childExit = runToHalt(*child);
+
+        ct::expect(t.loaded and ct::lift(parentExit == PDP8::RunExit::Halt)
+                   and ct::lift(childExit == PDP8::RunExit::Halt)
+                   and ct::lift(decWriter != parent.decWriter)
+                   and ct::lift(child->iotDevices.at(4) == child->iotDevices.at(3))
+                   and ct::lift(child->getCycleCount() == parent.pdp8.getCycleCount())
+                   and ct::lift(parent.output.str() == "A") and ct::lift(output.str().empty())
+                   and child->memory.programCounter.getProgramCounter() == 0210_i);
+    };
+}};
+
+auto const suite27 = ct::Suite{"Core Metadata", [] {
+    "Bitplanes"_test = [] {
+        PDP8 pdp8{};
+        pdp8.memory.write(0, 0200, 07777, true);
+        pdp8.memory.write(2, 0300, 01234, false);
+        pdp8.memory.memoryAddress.value = 0200;
+        pdp8.memory.memoryBuffer.setData(05);
+        pdp8.memory.write();
+
+        std::vector<std::size_t> programmed{};
+        pdp8.memory.getProgrammed().forEach([&programmed](std::size_t location) {
+            programmed.push_back(location);
+        });
+        ct::expect(pdp8.memory.peek(0200) == 05_i and pdp8.memory.peek(020300) == 01234_i
+                   and ct::lift(pdp8.memory.initialized(0200)) and ct::lift(pdp8.memory.initialized(020300))
+                   and ct::lift(!pdp8.memory.initialized(0201)) and ct::lift(pdp8.memory.programmed(0200))
+                   and ct::lift(!pdp8.memory.programmed(020300))
+                   and pdp8.memory.getInitialized().count() == 2_i
+                   and ct::lift(programmed == std::vector<std::size_t>{0200}));
+    };
+    "Snapshot"_test = [] {
+        PDP8 first{};
+        first.memory.write(0, 0200, 0, true);
+        first.memory.write(7, 07777, 04000, false);
+        std::stringstream snapshot{};
+        first.saveSnapshot(snapshot);
+        PDP8 second{};
+        second.memory.write(1, 0, 01, true);
+        second.restoreSnapshot(snapshot);
+        ct::expect(ct::lift(second.memory.initialized(0200)) and ct::lift(second.memory.programmed(0200))
+                   and ct::lift(second.memory.initialized(077777)) and ct::lift(!second.memory.programmed(077777))
+                   and ct::lift(!second.memory.initialized(010000)) and second.memory.peek(010000) == 0_i
+                   and second.memory.peek(077777) == 04000_i and second.memory.getInitialized().count() == 2_i);
+    };
+}};
+
+auto const suite28 = ct::Suite{"Sanitizer", [] {
+    static constexpr std::string_view Program =
+            "OCTAL\n*0200\nCLA\nTAD 0220\nTAD 0220\nJMP 0230\n*0231\nHLT\n*0200\n";
+    "Log"_test = [] {
+        bool all = true;
+        for (auto engine: {PDP8::ExecutionEngine::Switch, PDP8::ExecutionEngine::Threaded,
+                           PDP8::ExecutionEngine::Block}) {
+            BatchAssembly t{Program, engine};
+            t.pdp8.setSanitizerMode(Sanitizer::Mode::Log);
+            t.pdp8.set_run_flag(true);
+            auto exit = t.pdp8.run(100);
+            auto &reports = t.pdp8.getSanitizer().getReports();
+            // The never written instruction at 0230 is AND 0230 with its operand address left unset, so it
+            // reads itself. Each location is reported once but every read is counted.
+            all = all && t.loaded && exit == PDP8::RunExit::Halt && reports.size() == 2
+                  && t.pdp8.getSanitizer().getAccessCount() == 4
+                  && Sanitizer::format(reports[0]) == "Read of 0:0220 uninitialized at PC 0:0201"
+                  && Sanitizer::format(reports[1]) == "Execute of 0:0230 uninitialized at PC 0:0230";
+        }
+        ct::expect(ct::lift(all));
+    };
+    "Trap"_test = [] {
+        bool all = true;
+        for (auto engine: {PDP8::ExecutionEngine::Switch, PDP8::ExecutionEngine::Threaded,
+                           PDP8::ExecutionEngine::Block}) {
+            BatchAssembly t{Program, engine};
+            t.pdp8.setSanitizerMode(Sanitizer::Mode::Trap);
+            t.pdp8.set_run_flag(true);
+            auto first = t.pdp8.run(100);
+            auto pc = t.pdp8.memory.programCounter.getProgramCounter();
+            t.pdp8.set_run_flag(true);
+            auto second = t.pdp8.run(100);
+            all = all && t.loaded && first == PDP8::RunExit::SanitizerTrap && pc == 0202
+                  && second == PDP8::RunExit::SanitizerTrap
+                  && t.pdp8.memory.programCounter.getProgramCounter() == 0203
+                  && t.pdp8.getSanitizer().getReports().size() == 1;
+        }
+        ct::expect(ct::lift(all));
+    };
+    "Console Fault"_test = [] {
+        BatchAssembly t{Program};
+        t.pdp8.setSanitizerMode(Sanitizer::Mode::Trap);
+        std::optional<std::string> fault{};
+        {
+            CpuRunner runner{t.pdp8};
+            runner.perform([](PDP8 &cpu) { cpu.set_run_flag(true); });
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+            while (!fault && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+                fault = runner.takeFault();
+            }
+        }
+        ct::expect(ct::lift(fault.value_or("") == "Read of 0:0220 uninitialized at PC 0:0201"));
+    };
+    "Off"_test = [] {
+        BatchAssembly t{Program};
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(ct::lift(exit == PDP8::RunExit::Halt) and t.pdp8.getSanitizer().getAccessCount() == 0_i);
+    };
+}};
+
+auto const suite29 = ct::Suite{"Trace", [] {
+    static constexpr std::string_view Program =
+            "OCTAL\n*0200\nCLA CLL\nTAD Val\nDCA I Ptr\nHLT\nVal, 0123\nPtr, 0300\n*0200\n";
+    "Records"_test = [] {
+        bool all = true;
+        for (auto engine: {PDP8::ExecutionEngine::Switch, PDP8::ExecutionEngine::Threaded,
+                           PDP8::ExecutionEngine::Block}) {
+            BatchAssembly t{Program, engine};
+            t.pdp8.enableTrace(16);
+            t.pdp8.set_run_flag(true);
+            t.pdp8.run(100);
+            auto records = t.pdp8.getTrace()->records();
+            all = all && t.loaded && records.size() == 4
+                  && records[1] == TraceRecord{0201, 01204, 0204, 0123, 0}
+                  && records[2] == TraceRecord{0202, 03605, 0300, 0, 0}
+                  && records[3].location == 0203 && records[3].instruction == 07402;
+        }
+        ct::expect(ct::lift(all));
+    };
+    "Wrap"_test = [] {
+        TraceBuffer trace{3};
+        for (uint16_t idx = 0; idx < 10; ++idx)
+            trace.add(TraceRecord{idx, 0, 0, 0, 0});
+        auto records = trace.records();
+        ct::expect(trace.capacity() == 4_i and records.size() == 4_i and records.front().location == 6_i
+                   and records.back().location == 9_i);
+    };
+    "Concurrent Dump"_test = [] {
+        TraceBuffer trace{64};
+        std::atomic<bool> done{false};
+        std::jthread cpu{[&trace, &done] {
+            for (unsigned idx = 0; !done; ++idx) {
+                auto value = static_cast<uint16_t>(idx);
+                trace.add(TraceRecord{value, value, value, value, value});
+            }
+        }};
+        while (trace.count() < trace.capacity())
+            std::this_thread::yield();
+        // Every field of a record holds the same value and each record follows the one before.
+        unsigned errors = 0;
+        for (unsigned dump = 0; dump < 100000; ++dump) {
+            auto records = trace.records();
+            for (std::size_t idx = 0; idx < records.size(); ++idx) {
+                auto &record = records[idx];
+                errors += record.instruction != record.location || record.address != record.location
+                          || record.arithmetic != record.location || record.mulQuotient != record.location;
+                if (idx > 0)
+                    errors += record.location != static_cast<uint16_t>(records[idx - 1].location + 1);
+            }
+        }
+        done = true;
+        ct::expect(errors == 0_i);
+    };
+    "Dump On Halt"_test = [] {
+        auto file = std::filesystem::temp_directory_path() / "ct_OprInst-trace.bin";
+        BatchAssembly t{Program};
+        t.pdp8.enableTrace(16, file);
+        t.pdp8.set_run_flag(true);
+        t.pdp8.run(100);
+        std::ifstream dump{file, std::ios::binary};
+        auto records = TraceBuffer::read(dump);
+        dump.close();
+        std::filesystem::remove(file);
+        ct::expect(ct::lift(records == t.pdp8.getTrace()->records()));
+    };
+    "Disassemble"_test = [] {
+        Assembler assembler{};
+        std::stringstream source{std::string{Program}};
+        assembler.readProgram(source);
+        assembler.pass1();
+        Disassembler disassembler{assembler.symbolTable};
+        ct::expect(disassembler.disassemble(07300, 0200) == "CLA CLL"
+                   and disassembler.disassemble(01204, 0201) == "TAD Val"
+                   and disassembler.disassemble(03605, 0202) == "DCA I Ptr"
+                   and disassembler.disassemble(05020, 0203) == "JMP 0020"
+                   and disassembler.disassemble(07402, 0203) == "HLT"
+                   and disassembler.disassemble(07640, 0) == "SZA CLA"
+                   and disassembler.disassemble(07450, 0) == "SNA"
+                   and disassembler.disassemble(07010, 0) == "RAR"
+                   and disassembler.disassemble(06046, 0) == "TLS"
+                   and disassembler.disassemble(07000, 0) == "NOP"
+                   and disassembler.disassemble(07410, 0) == "7410");
+    };
+}};
+
+auto const suite30 = ct::Suite{"Trace Stream", [] {
+    static constexpr std::string_view Program =
+            "OCTAL\n*0200\nLoop, TAD One\nISZ Cnt\nNOP\nJMP Loop\nOne, 0003\nCnt, 0\n*0200\n";
+    "Matches Buffer"_test = [] {
+        auto file = std::filesystem::temp_directory_path() / "ct_OprInst-stream.bin";
+        BatchAssembly t{Program};
+        t.pdp8.enableTrace(1u << 17);
+        t.pdp8.enableTraceStream(file);
+        t.pdp8.set_run_flag(true);
+        t.pdp8.run(100000);
+        auto count = t.pdp8.getTraceStream()->count();
+        auto written = t.pdp8.disableTraceStream();
+
+        std::vector<TraceRecord> records{};
+        std::ifstream strm{file, std::ios::binary};
+        TraceStreamReader reader{strm};
+        for (TraceRecord record{}; reader.next(record);)
+            records.push_back(record);
+        strm.close();
+        std::filesystem::remove(file);
+        ct::expect(ct::lift(written) and count == 100000_i and records.size() == 100000_i
+                   and ct::lift(records == t.pdp8.getTrace()->records()));
+    };
+    "Truncated"_test = [] {
+        auto file = std::filesystem::temp_directory_path() / "ct_OprInst-stream.bin";
+        {
+            TraceStreamWriter writer{file};
+            for (uint16_t idx = 0; idx < 1000; ++idx)
+                writer.add(TraceRecord{idx, 01000, idx, idx, 0});
+        }
+        std::ifstream input{file, std::ios::binary};
+        std::string contents{std::istreambuf_iterator<char>{input}, {}};
+        input.close();
+        std::filesystem::remove(file);
+
+        std::stringstream damaged{contents.substr(0, contents.size() - 10)};
+        TraceStreamReader reader{damaged};
+        TraceRecord record{};
+        bool thrown = false;
+        try {
+            while (reader.next(record));
+        } catch (const SnapshotError &) {
+            thrown = true;
+        }
+        ct::expect(ct::lift(thrown));
+    };
+}};
+
+auto const suite31 = ct::Suite{"Breakpoints", [] {
+    static constexpr std::string_view Program =
+            "OCTAL\n*0200\nCLA\nLoop, TAD One\nDCA Sum\nTAD Sum\nISZ Cnt\nJMP Loop\nHLT\n"
+            "One, 0001\nSum, 0\nCnt, 7775\n*0200\n";
+    static constexpr std::array Engines{PDP8::ExecutionEngine::Switch, PDP8::ExecutionEngine::Threaded,
+                                        PDP8::ExecutionEngine::Block};
+    "Execute"_test = [] {
+        bool all = true;
+        for (auto engine: Engines) {
+            BatchAssembly t{Program, engine};
+            t.pdp8.setBreakpoint({Breakpoints::Access::Execute, 0202});
+            t.pdp8.set_run_flag(true);
+            auto first = t.pdp8.run(100);
+            auto firstAcc = t.pdp8.accumulator.getAcc();
+            auto pc = t.pdp8.memory.programCounter.getProgramCounter();
+            t.pdp8.set_run_flag(true);
+            auto second = t.pdp8.run(100);
+            all = all && t.loaded && first == PDP8::RunExit::Breakpoint && !t.pdp8.get_run_flag() && pc == 0202
+                  && firstAcc == 1 && second == PDP8::RunExit::Breakpoint && t.pdp8.accumulator.getAcc() == 2
+                  && Breakpoints::format(t.pdp8.getBreakpoints().getHit().value())
+                     == "Breakpoint Execute 0:0202 at PC 0:0202";
+        }
+        ct::expect(ct::lift(all));
+    };
+    "Condition"_test = [] {
+        BatchAssembly t{Program};
+        t.pdp8.setBreakpoint({Breakpoints::Access::Execute, 0202, 3});
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(ct::lift(exit == PDP8::RunExit::Breakpoint) and t.pdp8.accumulator.getAcc() == 3_i
+                   and t.pdp8.memory.programCounter.getProgramCounter() == 0202_i);
+    };
+    "Watch"_test = [] {
+        bool all = true;
+        for (auto engine: Engines) {
+            BatchAssembly t{Program, engine};
+            t.pdp8.setBreakpoint({Breakpoints::Access::Write, 0210});
+            t.pdp8.setBreakpoint({Breakpoints::Access::Read, 0207, 0});
+            t.pdp8.set_run_flag(true);
+            auto read = t.pdp8.run(100);
+            auto readHit = Breakpoints::format(t.pdp8.getBreakpoints().getHit().value());
+            auto readPc = t.pdp8.memory.programCounter.getProgramCounter();
+            t.pdp8.set_run_flag(true);
+            auto write = t.pdp8.run(100);
+            all = all && t.loaded && read == PDP8::RunExit::Breakpoint && readPc == 0202
+                  && readHit == "Breakpoint Read 0:0207 if AC 0000 at PC 0:0201"
+                  && write == PDP8::RunExit::Breakpoint && t.pdp8.memory.programCounter.getProgramCounter() == 0203
+                  && Breakpoints::format(t.pdp8.getBreakpoints().getHit().value())
+                     == "Breakpoint Write 0:0210 at PC 0:0202";
+        }
+        ct::expect(ct::lift(all));
+    };
+    "Step Over"_test = [] {
+        BatchAssembly t{Program};
+        t.pdp8.setBreakpoint({Breakpoints::Access::Execute, 0200});
+        auto exit = t.pdp8.step();
+        ct::expect(ct::lift(exit != PDP8::RunExit::Breakpoint)
+                   and t.pdp8.memory.programCounter.getProgramCounter() == 0201_i);
+    };
+    "Clear"_test = [] {
+        BatchAssembly t{Program};
+        t.pdp8.setBreakpoint({Breakpoints::Access::Execute, 0202});
+        t.pdp8.setBreakpoint({Breakpoints::Access::Write, 0202});
+        auto cleared = t.pdp8.clearBreakpoint(0202);
+        t.pdp8.set_run_flag(true);
+        auto exit = t.pdp8.run(100);
+        ct::expect(ct::lift(cleared) and ct::lift(exit == PDP8::RunExit::Halt)
+                   and t.pdp8.getBreakpoints().empty());
+    };
+}};